@@ -0,0 +1,1166 @@
+#pragma once
+#include "radix_heap.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace radix_heap {
+namespace internal {
+// xorshift64* random generator [Vigna, 2014], one per thread.
+inline uint64_t thread_random() {
+  static std::atomic<uint64_t> seed(88172645463325252ULL);
+  thread_local uint64_t x = seed.fetch_add(0x9E3779B97F4A7C15ULL) | 1;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  return x * 2685821657736338717ULL;
+}
+
+// A |pair_radix_heap| of encoded keys protected by a mutex. Keys less than
+// the last extracted key are kept in a binary heap instead, so that any key
+// can be pushed.
+template<typename UnsignedKeyType, typename ValueType>
+struct locked_shard {
+  typedef UnsignedKeyType unsigned_key_type;
+  typedef ValueType value_type;
+  static constexpr unsigned_key_type kEmpty = internal::key_traits<unsigned_key_type>::max();
+
+  struct late_greater {
+    bool operator()(const std::pair<unsigned_key_type, value_type> &a,
+                    const std::pair<unsigned_key_type, value_type> &b) const {
+      return a.first > b.first;
+    }
+  };
+
+  std::mutex mutex;
+  // The minimum key, or |kEmpty|. It is read without the lock.
+  std::atomic<unsigned_key_type> top;
+  // The last key extracted from |heap|.
+  unsigned_key_type watermark;
+  pair_radix_heap<unsigned_key_type, value_type> heap;
+  std::priority_queue<std::pair<unsigned_key_type, value_type>,
+                      std::vector<std::pair<unsigned_key_type, value_type>>,
+                      late_greater> late;
+  // Keeps shards on separate cache lines.
+  char padding[64];
+
+  locked_shard() : top(kEmpty), watermark() {}
+
+  bool empty() const {
+    return heap.empty() && late.empty();
+  }
+
+  void push(unsigned_key_type x, const value_type &value) {
+    if (x < watermark && heap.empty()) {
+      heap.clear();
+      watermark = unsigned_key_type();
+    }
+    if (watermark <= x) heap.push(x, value);
+    else late.emplace(x, value);
+    if (x < top.load(std::memory_order_relaxed)) top.store(x, std::memory_order_relaxed);
+  }
+
+  void pop(unsigned_key_type *x, value_type *value) {
+    if (!heap.empty()) watermark = heap.top_key();
+    if (!late.empty() && (heap.empty() || late.top().first < watermark)) {
+      *x = late.top().first;
+      *value = late.top().second;
+      late.pop();
+    } else {
+      *x = watermark;
+      *value = std::move(heap.top_value());
+      heap.pop();
+    }
+    update_top();
+  }
+
+  void update_top() {
+    unsigned_key_type t = kEmpty;
+    if (!heap.empty()) t = watermark = heap.top_key();
+    if (!late.empty()) t = std::min(t, late.top().first);
+    top.store(t, std::memory_order_relaxed);
+  }
+};
+
+// The NUMA node of each CPU, read from sysfs. Empty if unknown.
+inline std::vector<int> read_numa_nodes_of_cpus() {
+  std::vector<int> res;
+#ifdef __linux__
+  // Node numbers may be sparse.
+  for (int node = 0; node < 256; ++node) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) continue;
+    // A list of ranges such as "0-7,16-23".
+    int b, e;
+    while (fscanf(fp, "%d", &b) == 1) {
+      e = b;
+      int c = fgetc(fp);
+      if (c == '-' && fscanf(fp, "%d", &e) == 1) c = fgetc(fp);
+      if (e >= (int)res.size()) res.resize(e + 1, 0);
+      for (int cpu = b; cpu <= e; ++cpu) res[cpu] = node;
+      if (c != ',') break;
+    }
+    fclose(fp);
+  }
+#endif
+  return res;
+}
+
+inline int numa_node_of_cpu(int cpu) {
+  static const std::vector<int> nodes = read_numa_nodes_of_cpus();
+  return 0 <= cpu && cpu < (int)nodes.size() ? nodes[cpu] : 0;
+}
+
+// The NUMA node the calling thread is running on.
+inline int current_numa_node() {
+#ifdef __linux__
+  return numa_node_of_cpu(sched_getcpu());
+#else
+  return 0;
+#endif
+}
+}  // namespace internal
+
+// A relaxed concurrent priority queue (MultiQueue [Rihani et al., 2015]) of
+// lock-protected |pair_radix_heap| shards. |push| inserts into a random shard
+// and |try_pop| takes the smaller top of two random shards, so the popped key
+// is close to, but not always, the global minimum.
+//
+// A shard can have extracted a larger key than one pushed later. Such keys
+// are kept in a small binary heap of the shard, so pushes never violate the
+// monotonicity of the radix heap, and |lower_bound| tells how far behind
+// the shards a key may be pushed cheaply.
+template<typename KeyType, typename ValueType, typename EncoderType = internal::encoder<KeyType>>
+class concurrent_radix_multiqueue {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+
+  // Uses |shards_per_thread * num_threads| shards.
+  explicit concurrent_radix_multiqueue(size_t num_threads, size_t shards_per_thread = 2)
+      : num_shards_(std::max<size_t>(2, num_threads * shards_per_thread)),
+        shards_(new shard[num_shards_]), size_(0) {}
+
+  void push(key_type key, const value_type &value) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    for (;;) {
+      shard &s = shards_[internal::thread_random() % num_shards_];
+      std::unique_lock<std::mutex> lock(s.mutex, std::try_to_lock);
+      if (!lock.owns_lock()) continue;
+      s.push(x, value);
+      size_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  // Pops an element with a small key. Returns false if the queue is empty.
+  bool try_pop(key_type *key, value_type *value) {
+    for (size_t trial = 0; ; ++trial) {
+      if (size_.load(std::memory_order_relaxed) == 0) return false;
+      shard *s1 = &shards_[internal::thread_random() % num_shards_];
+      shard *s2 = &shards_[internal::thread_random() % num_shards_];
+      if (s2->top.load(std::memory_order_relaxed) < s1->top.load(std::memory_order_relaxed)) {
+        std::swap(s1, s2);
+      }
+      // Sampling keeps missing the few nonempty shards, so also scan all of them.
+      if (trial >= num_shards_) s1 = &shards_[trial % num_shards_];
+
+      std::unique_lock<std::mutex> lock(s1->mutex, std::try_to_lock);
+      if (!lock.owns_lock() || s1->empty()) continue;
+      unsigned_key_type x;
+      s1->pop(&x, value);
+      *key = encoder_type::decode(x);
+      size_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  // No key less than this is in the queue, up to concurrent updates.
+  // It is |std::numeric_limits<key_type>::max()| if the queue is empty.
+  key_type lower_bound() const {
+    unsigned_key_type x = kEmpty;
+    for (size_t i = 0; i < num_shards_; ++i) {
+      x = std::min(x, shards_[i].top.load(std::memory_order_relaxed));
+    }
+    return x == kEmpty ? std::numeric_limits<key_type>::max() : encoder_type::decode(x);
+  }
+
+  size_t size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+ private:
+  typedef internal::locked_shard<unsigned_key_type, value_type> shard;
+  static constexpr unsigned_key_type kEmpty = shard::kEmpty;
+
+  const size_t num_shards_;
+  std::unique_ptr<shard[]> shards_;
+  std::atomic<size_t> size_;
+};
+
+// A single-consumer |pair_radix_heap| fed by many producer threads without
+// locks. Each producer owns a bounded single-producer single-consumer ring,
+// and the consumer drains all rings into the heap in batches before it
+// looks at the minimum.
+//
+// Keys must not be less than the last key extracted by the consumer at the
+// time they are drained. Elements violating it are not added to the heap but
+// are kept aside in |late|.
+template<typename KeyType, typename ValueType, typename EncoderType = internal::encoder<KeyType>>
+class mpsc_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+  typedef std::pair<key_type, value_type> element_type;
+
+ private:
+  class ring {
+   public:
+    explicit ring(size_t capacity)
+        : mask_(capacity - 1), slots_(new slot[capacity]), head_(0), tail_(0), cached_head_(0) {
+      assert(capacity > 0 && (capacity & mask_) == 0);
+    }
+
+    ~ring() {
+      for (size_t i = head_.load(); i != tail_.load(); ++i) get(i)->~element_type();
+    }
+
+    template<class... Args>
+    bool try_emplace(Args&&... args) {
+      const size_t t = tail_.load(std::memory_order_relaxed);
+      if (t - cached_head_ > mask_) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (t - cached_head_ > mask_) return false;
+      }
+      new (get(t)) element_type(std::forward<Args>(args)...);
+      tail_.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Called only by the consumer.
+    template<typename Function>
+    void consume_all(Function f) {
+      const size_t h = head_.load(std::memory_order_relaxed);
+      const size_t t = tail_.load(std::memory_order_acquire);
+      for (size_t i = h; i != t; ++i) {
+        element_type *e = get(i);
+        f(*e);
+        e->~element_type();
+      }
+      head_.store(t, std::memory_order_release);
+    }
+
+   private:
+    typedef typename std::aligned_storage<sizeof(element_type), alignof(element_type)>::type slot;
+
+    const size_t mask_;
+    std::unique_ptr<slot[]> slots_;
+    // Written by the consumer and by the producer, respectively.
+    std::atomic<size_t> head_;
+    char padding1_[64];
+    std::atomic<size_t> tail_;
+    size_t cached_head_;
+    char padding2_[64];
+
+    element_type *get(size_t i) {
+      return reinterpret_cast<element_type*>(&slots_[i & mask_]);
+    }
+  };
+
+ public:
+  // A handle for one producer thread.
+  class producer {
+   public:
+    producer() : ring_(NULL) {}
+
+    // Returns false if the ring of this producer is full.
+    bool try_push(key_type key, const value_type &value) {
+      return ring_->try_emplace(key, value);
+    }
+
+    bool try_push(key_type key, value_type &&value) {
+      return ring_->try_emplace(key, std::move(value));
+    }
+
+    // Waits for the consumer while the ring is full.
+    void push(key_type key, const value_type &value) {
+      while (!try_push(key, value)) std::this_thread::yield();
+    }
+
+   private:
+    friend class mpsc_radix_heap;
+    explicit producer(ring *r) : ring_(r) {}
+    ring *ring_;
+  };
+
+  // Up to |max_producers| producers, each with a ring of |ring_capacity|
+  // elements (a power of two).
+  explicit mpsc_radix_heap(size_t max_producers, size_t ring_capacity = 1024)
+      : max_producers_(max_producers), ring_capacity_(ring_capacity),
+        rings_(new std::atomic<ring*>[max_producers]), num_producers_(0),
+        watermark_() {
+    for (size_t i = 0; i < max_producers_; ++i) rings_[i] = NULL;
+  }
+
+  ~mpsc_radix_heap() {
+    for (size_t i = 0; i < max_producers_; ++i) delete rings_[i].load();
+  }
+
+  // Registers a new producer. It can be called from any thread. Throws
+  // |std::length_error| if |max_producers| are already registered.
+  producer make_producer() {
+    const size_t i = num_producers_.fetch_add(1);
+    if (i >= max_producers_) throw std::length_error("mpsc_radix_heap: too many producers");
+    ring *r = new ring(ring_capacity_);
+    rings_[i].store(r, std::memory_order_release);
+    return producer(r);
+  }
+
+  // The following member functions are for the consumer thread.
+
+  // Moves everything pushed so far into the heap. Elements whose keys are
+  // less than the last extracted key are appended to |late| instead.
+  // Returns the number of such elements.
+  size_t drain() {
+    size_t num_late = 0;
+    const size_t n = std::min(num_producers_.load(), max_producers_);
+    for (size_t i = 0; i < n; ++i) {
+      ring *r = rings_[i].load(std::memory_order_acquire);
+      if (r == NULL) continue;
+      r->consume_all([&](element_type &e) {
+          if (encoder_type::encode(e.first) < watermark_) {
+            ++num_late;
+            late_.emplace_back(std::move(e));
+          } else {
+            heap_.push(e.first, std::move(e.second));
+          }
+        });
+    }
+    return num_late;
+  }
+
+  key_type top_key() {
+    drain();
+    const key_type k = heap_.top_key();
+    watermark_ = encoder_type::encode(k);
+    return k;
+  }
+
+  value_type &top_value() {
+    top_key();
+    return heap_.top_value();
+  }
+
+  // Does not drain, so that the element just read by |top_value| is the one
+  // removed.
+  void pop() {
+    watermark_ = encoder_type::encode(heap_.top_key());
+    heap_.pop();
+  }
+
+  size_t size() {
+    drain();
+    return heap_.size();
+  }
+
+  bool empty() {
+    drain();
+    return heap_.empty();
+  }
+
+  // Elements which were pushed too late. The consumer may handle and
+  // remove them as it likes.
+  std::vector<element_type> &late() {
+    return late_;
+  }
+
+ private:
+  const size_t max_producers_, ring_capacity_;
+  std::unique_ptr<std::atomic<ring*>[]> rings_;
+  std::atomic<size_t> num_producers_;
+  pair_radix_heap<key_type, value_type, encoder_type> heap_;
+  unsigned_key_type watermark_;
+  std::vector<element_type> late_;
+};
+
+// A |pair_radix_heap| accepting |push| from many threads concurrently with
+// one consumer thread calling |try_pop|.
+//
+// Each bucket is an append-only array of geometrically growing segments, in
+// which producers reserve slots by an atomic tail, and bucket minima are
+// lowered by compare-and-swap. Producers register themselves in a gate word
+// while they append. Bucket 0 is consumed concurrently with appends; to
+// redistribute other buckets, the consumer closes the gate and waits for
+// active producers to leave, after which it has the buckets to itself.
+// Producers arriving while the gate is closed push onto a lock-free stack,
+// which the consumer drains during the handoff.
+//
+// Keys less than the last key extracted by the consumer are accepted and
+// popped before the others, so that nothing is lost in a timer service.
+template<typename KeyType, typename ValueType, typename EncoderType = internal::encoder<KeyType>>
+class concurrent_push_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+
+  concurrent_push_radix_heap()
+      : gate_(0), last_(), incoming_(NULL), late_incoming_(NULL), size_(0) {}
+
+  ~concurrent_push_radix_heap() {
+    for (size_t k = 0; k < kNumBuckets; ++k) buckets_[k].destroy();
+    for (node *n : {incoming_.load(), late_incoming_.load()}) {
+      while (n != NULL) {
+        node *next = n->next;
+        delete n;
+        n = next;
+      }
+    }
+  }
+
+  // Can be called from any thread.
+  void push(key_type key, const value_type &value) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    // Counted before the element is published, so that the consumer never
+    // decrements the size below zero.
+    size_.fetch_add(1, std::memory_order_relaxed);
+    bool late = false;
+    if ((gate_.fetch_add(1, std::memory_order_acquire) & kClosed) == 0) {
+      // |last_| does not change until we leave the gate.
+      const unsigned_key_type l = last_.load(std::memory_order_relaxed);
+      if (l <= x) {
+        buckets_[internal::find_bucket(x, l)].append(x, value);
+        gate_.fetch_sub(1, std::memory_order_release);
+        return;
+      }
+      late = true;
+    }
+    gate_.fetch_sub(1, std::memory_order_release);
+
+    std::atomic<node*> &stack = late ? late_incoming_ : incoming_;
+    node *n = new node(x, value);
+    n->next = stack.load(std::memory_order_relaxed);
+    while (!stack.compare_exchange_weak(n->next, n, std::memory_order_release,
+                                        std::memory_order_relaxed));
+  }
+
+  // The following member functions are for the consumer thread.
+
+  // Pops an element with the minimum key among those whose pushes have
+  // completed. Returns false if there is none.
+  bool try_pop(key_type *key, value_type *value) {
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      drain(late_incoming_);
+      if (!late_.empty()) {
+        *key = encoder_type::decode(late_.top().first);
+        *value = late_.top().second;
+        late_.pop();
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+      unsigned_key_type x;
+      if (buckets_[0].try_take(&x, value)) {
+        *key = encoder_type::decode(x);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+      if (size() == 0) return false;
+      handoff();
+    }
+    return false;
+  }
+
+  // The number of elements, including those whose pushes are in progress.
+  size_t size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+ private:
+  static constexpr size_t kNumBuckets = internal::key_traits<unsigned_key_type>::digits + 1;
+  static constexpr uint64_t kClosed = uint64_t(1) << 63;
+
+  struct slot {
+    std::atomic<bool> ready;
+    unsigned_key_type key;
+    typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type value;
+
+    slot() : ready(false) {}
+
+    value_type *get() {
+      return reinterpret_cast<value_type*>(&value);
+    }
+  };
+
+  // An append-only array. Segment |s| holds |kFirstSegmentSize << s| slots,
+  // and segments are kept for reuse after the bucket is emptied.
+  class bucket {
+   public:
+    bucket() : tail_(0), head_(0), min_(internal::key_traits<unsigned_key_type>::max()) {
+      for (auto &s : segments_) s = NULL;
+    }
+
+    // Can be called concurrently by producers.
+    template<typename Value>
+    void append(unsigned_key_type x, Value &&value) {
+      slot *s = at(tail_.fetch_add(1, std::memory_order_relaxed));
+      s->key = x;
+      new (s->get()) value_type(std::forward<Value>(value));
+      s->ready.store(true, std::memory_order_release);
+
+      unsigned_key_type m = min_.load(std::memory_order_relaxed);
+      while (x < m && !min_.compare_exchange_weak(m, x, std::memory_order_relaxed));
+    }
+
+    // Takes the slot at the head, waiting for a producer still writing it.
+    // Called only by the consumer.
+    bool try_take(unsigned_key_type *x, value_type *value) {
+      if (head_ == tail_.load(std::memory_order_acquire)) return false;
+      slot *s = at(head_++);
+      while (!s->ready.load(std::memory_order_acquire)) std::this_thread::yield();
+      *x = s->key;
+      *value = std::move(*s->get());
+      s->get()->~value_type();
+      s->ready.store(false, std::memory_order_relaxed);
+      return true;
+    }
+
+    // The following are called only while no producer is active.
+
+    bool empty() const {
+      return head_ == tail_.load(std::memory_order_relaxed);
+    }
+
+    unsigned_key_type min() const {
+      return min_.load(std::memory_order_relaxed);
+    }
+
+    template<typename Function>
+    void consume_all(Function f) {
+      const size_t t = tail_.load(std::memory_order_relaxed);
+      for (size_t i = head_; i < t; ++i) {
+        slot *s = at(i);
+        f(s->key, std::move(*s->get()));
+        s->get()->~value_type();
+        s->ready.store(false, std::memory_order_relaxed);
+      }
+      reset();
+    }
+
+    void reset() {
+      head_ = 0;
+      tail_.store(0, std::memory_order_relaxed);
+      min_.store(internal::key_traits<unsigned_key_type>::max(), std::memory_order_relaxed);
+    }
+
+    void destroy() {
+      consume_all([](unsigned_key_type, value_type &&) {});
+      for (auto &s : segments_) delete[] s.load();
+    }
+
+   private:
+    static constexpr size_t kFirstSegmentSize = 16;
+    static constexpr size_t kNumSegments = 48;
+
+    std::atomic<size_t> tail_;
+    size_t head_;
+    std::atomic<unsigned_key_type> min_;
+    std::atomic<slot*> segments_[kNumSegments];
+
+    slot *at(size_t i) {
+      // Segment |s| starts at |kFirstSegmentSize * (2^s - 1)|.
+      const size_t q = i / kFirstSegmentSize + 1;
+      const size_t s = internal::find_bucket<uint64_t>(q, 0) - 1;
+      const size_t offset = i - kFirstSegmentSize * ((size_t(1) << s) - 1);
+      slot *seg = segments_[s].load(std::memory_order_acquire);
+      if (seg == NULL) {
+        slot *fresh = new slot[kFirstSegmentSize << s];
+        if (segments_[s].compare_exchange_strong(seg, fresh, std::memory_order_acq_rel)) {
+          seg = fresh;
+        } else {
+          delete[] fresh;
+        }
+      }
+      return seg + offset;
+    }
+  };
+
+  struct node {
+    unsigned_key_type key;
+    value_type value;
+    node *next;
+
+    node(unsigned_key_type x, const value_type &v) : key(x), value(v), next(NULL) {}
+  };
+
+  struct late_greater {
+    bool operator()(const std::pair<unsigned_key_type, value_type> &a,
+                    const std::pair<unsigned_key_type, value_type> &b) const {
+      return a.first > b.first;
+    }
+  };
+
+  // The closed flag (|kClosed|) and the number of active producers.
+  std::atomic<uint64_t> gate_;
+  char padding_[64];
+  std::atomic<unsigned_key_type> last_;
+  // Elements pushed while the gate is closed, and those with keys less
+  // than |last_|.
+  std::atomic<node*> incoming_, late_incoming_;
+  std::atomic<size_t> size_;
+  bucket buckets_[kNumBuckets];
+  std::priority_queue<std::pair<unsigned_key_type, value_type>,
+                      std::vector<std::pair<unsigned_key_type, value_type>>,
+                      late_greater> late_;
+
+  // Places an element. Buckets are touched only while no producer is active.
+  void place(unsigned_key_type x, value_type &&value) {
+    const unsigned_key_type l = last_.load(std::memory_order_relaxed);
+    if (x < l) late_.emplace(x, std::move(value));
+    else buckets_[internal::find_bucket(x, l)].append(x, std::move(value));
+  }
+
+  // Moves the elements in |stack| to the buckets or to |late_|. Since
+  // |last_| never decreases, elements of |late_incoming_| always go to
+  // |late_|, so they can be drained while producers are active.
+  void drain(std::atomic<node*> &stack) {
+    if (stack.load(std::memory_order_relaxed) == NULL) return;
+    for (node *n = stack.exchange(NULL, std::memory_order_acquire); n != NULL; ) {
+      node *next = n->next;
+      place(n->key, std::move(n->value));
+      delete n;
+      n = next;
+    }
+  }
+
+  // Takes the buckets from producers, drains |incoming_| and, if bucket 0 is
+  // empty, redistributes the first non-empty bucket.
+  void handoff() {
+    gate_.fetch_or(kClosed, std::memory_order_acq_rel);
+    while ((gate_.load(std::memory_order_acquire) & ~kClosed) != 0) std::this_thread::yield();
+
+    drain(incoming_);
+
+    if (buckets_[0].empty()) {
+      buckets_[0].reset();
+      size_t i;
+      for (i = 1; i < kNumBuckets && buckets_[i].empty(); ++i);
+      if (i < kNumBuckets) {
+        last_.store(buckets_[i].min(), std::memory_order_relaxed);
+        buckets_[i].consume_all([this](unsigned_key_type x, value_type &&v) {
+            place(x, std::move(v));
+          });
+      }
+    }
+
+    gate_.fetch_and(~kClosed, std::memory_order_release);
+  }
+};
+
+// Executors run |f(0)|, ..., |f(n - 1)| possibly in parallel and return when
+// all of them finish. |concurrency| is the number of calls worth running at
+// the same time.
+class serial_executor {
+ public:
+  size_t concurrency() const {
+    return 1;
+  }
+
+  template<typename Function>
+  void run(size_t n, Function f) {
+    for (size_t i = 0; i < n; ++i) f(i);
+  }
+};
+
+// An executor with a persistent pool of |num_threads - 1| threads. The
+// calling thread also takes part in |run|.
+class thread_pool_executor {
+ public:
+  explicit thread_pool_executor(size_t num_threads = std::thread::hardware_concurrency())
+      : num_threads_(std::max<size_t>(1, num_threads)), generation_(0), stopping_(false),
+        num_tasks_(0), next_task_(0), num_running_(0) {
+    for (size_t i = 1; i < num_threads_; ++i) {
+      threads_.emplace_back([this]() { work(); });
+    }
+  }
+
+  ~thread_pool_executor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &t : threads_) t.join();
+  }
+
+  size_t concurrency() const {
+    return num_threads_;
+  }
+
+  template<typename Function>
+  void run(size_t n, Function f) {
+    if (n <= 1 || num_threads_ == 1) {
+      for (size_t i = 0; i < n; ++i) f(i);
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = f;
+    num_tasks_ = n;
+    next_task_ = 0;
+    num_running_ = threads_.size() + 1;
+    ++generation_;
+    lock.unlock();
+    wake_.notify_all();
+
+    execute();
+
+    lock.lock();
+    done_.wait(lock, [this]() { return num_running_ == 0; });
+    task_ = nullptr;
+  }
+
+ private:
+  const size_t num_threads_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_, done_;
+  size_t generation_;
+  bool stopping_;
+  std::function<void(size_t)> task_;
+  size_t num_tasks_;
+  std::atomic<size_t> next_task_;
+  size_t num_running_;
+
+  void execute() {
+    for (size_t i; (i = next_task_.fetch_add(1)) < num_tasks_; ) task_(i);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--num_running_ == 0) done_.notify_one();
+  }
+
+  void work() {
+    size_t generation = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&]() { return stopping_ || generation_ != generation; });
+        if (stopping_) return;
+        generation = generation_;
+      }
+      execute();
+    }
+  }
+};
+
+// An executor balancing uneven tasks by work stealing. Each worker owns a
+// deque of index ranges, initially a contiguous share of |0, ..., n - 1|.
+// A worker takes the most recently split range from the back of its own
+// deque and halves it until at most |grain| indices are left, pushing the
+// upper halves back; idle workers steal the largest ranges from the front of
+// the deques of others.
+//
+// |run_with_worker| also passes the index of the worker, so that each worker
+// can reuse its own workspace (e.g., a |pair_radix_heap| and a distance
+// array) across tasks. The calling thread is worker 0.
+class work_stealing_executor {
+ public:
+  explicit work_stealing_executor(size_t num_threads = std::thread::hardware_concurrency())
+      : num_threads_(std::max<size_t>(1, num_threads)), deques_(new range_deque[num_threads_]),
+        generation_(0), stopping_(false), grain_(1), num_remaining_(0), num_running_(0),
+        num_steals_(0) {
+    for (size_t w = 1; w < num_threads_; ++w) {
+      threads_.emplace_back([this, w]() { work(w); });
+    }
+  }
+
+  ~work_stealing_executor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &t : threads_) t.join();
+  }
+
+  size_t concurrency() const {
+    return num_threads_;
+  }
+
+  template<typename Function>
+  void run(size_t n, Function f) {
+    run_with_worker(n, 1, [&f](size_t, size_t i) { f(i); });
+  }
+
+  // Calls |f(worker, i)| for each |i| in |0, ..., n - 1|, where
+  // |worker < concurrency()|. Ranges of at most |grain| indices are not split.
+  template<typename Function>
+  void run_with_worker(size_t n, size_t grain, Function f) {
+    if (num_threads_ == 1 || n <= 1) {
+      for (size_t i = 0; i < n; ++i) f(0, i);
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (size_t w = 0; w < num_threads_; ++w) {
+      const size_t b = n * w / num_threads_, e = n * (w + 1) / num_threads_;
+      deques_[w].ranges.clear();
+      if (b < e) deques_[w].ranges.emplace_back(b, e);
+    }
+    task_ = f;
+    grain_ = std::max<size_t>(1, grain);
+    num_remaining_ = n;
+    num_running_ = threads_.size() + 1;
+    ++generation_;
+    lock.unlock();
+    wake_.notify_all();
+
+    execute(0);
+
+    lock.lock();
+    done_.wait(lock, [this]() { return num_running_ == 0; });
+    task_ = nullptr;
+  }
+
+  // The total number of ranges stolen so far.
+  size_t num_steals() const {
+    return num_steals_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  typedef std::pair<size_t, size_t> range;
+
+  struct range_deque {
+    std::mutex mutex;
+    std::deque<range> ranges;
+    // Keeps deques on separate cache lines.
+    char padding[64];
+  };
+
+  const size_t num_threads_;
+  std::unique_ptr<range_deque[]> deques_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_, done_;
+  size_t generation_;
+  bool stopping_;
+  std::function<void(size_t, size_t)> task_;
+  size_t grain_;
+  std::atomic<size_t> num_remaining_;
+  size_t num_running_;
+  std::atomic<size_t> num_steals_;
+
+  bool pop_back(size_t w, range *r) {
+    std::lock_guard<std::mutex> lock(deques_[w].mutex);
+    if (deques_[w].ranges.empty()) return false;
+    *r = deques_[w].ranges.back();
+    deques_[w].ranges.pop_back();
+    return true;
+  }
+
+  bool steal(size_t w, range *r) {
+    const size_t start = internal::thread_random() % num_threads_;
+    for (size_t k = 0; k < num_threads_; ++k) {
+      const size_t v = (start + k) % num_threads_;
+      if (v == w) continue;
+      std::lock_guard<std::mutex> lock(deques_[v].mutex);
+      if (deques_[v].ranges.empty()) continue;
+      *r = deques_[v].ranges.front();
+      deques_[v].ranges.pop_front();
+      num_steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  void execute(size_t w) {
+    range r;
+    while (num_remaining_.load(std::memory_order_acquire) > 0) {
+      if (!pop_back(w, &r) && !steal(w, &r)) {
+        std::this_thread::yield();
+        continue;
+      }
+      while (r.second - r.first > grain_) {
+        const size_t mid = r.first + (r.second - r.first) / 2;
+        {
+          std::lock_guard<std::mutex> lock(deques_[w].mutex);
+          deques_[w].ranges.emplace_back(mid, r.second);
+        }
+        r.second = mid;
+      }
+      for (size_t i = r.first; i < r.second; ++i) task_(w, i);
+      num_remaining_.fetch_sub(r.second - r.first, std::memory_order_release);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--num_running_ == 0) done_.notify_one();
+  }
+
+  void work(size_t w) {
+    size_t generation = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&]() { return stopping_ || generation_ != generation; });
+        if (stopping_) return;
+        generation = generation_;
+      }
+      execute(w);
+    }
+  }
+};
+
+#ifdef _OPENMP
+}  // namespace radix_heap
+#include <omp.h>
+namespace radix_heap {
+// An executor by OpenMP.
+class openmp_executor {
+ public:
+  size_t concurrency() const {
+    return omp_get_max_threads();
+  }
+
+  template<typename Function>
+  void run(size_t n, Function f) {
+#pragma omp parallel for schedule(static)
+    for (long long i = 0; i < (long long)n; ++i) f(i);
+  }
+};
+#endif
+
+namespace internal {
+// Redistributes buckets of at least |threshold| elements in parallel by
+// |Executor|. Chunks of the bucket are scanned to count elements for each
+// destination bucket, the counts are turned into offsets by prefix sums, and
+// then the chunks are scattered in parallel. Smaller buckets are
+// redistributed sequentially.
+template<typename Executor>
+class parallel_redistributor {
+ public:
+  parallel_redistributor() : executor_(NULL), threshold_(1) {}
+
+  parallel_redistributor(Executor &executor, size_t threshold)
+      : executor_(&executor), threshold_(std::max<size_t>(1, threshold)) {}
+
+  template<typename Buckets, typename BucketsMin, typename UnsignedKeyType>
+  void redistribute(Buckets &buckets, BucketsMin &buckets_min, size_t i, UnsignedKeyType last) {
+    if (executor_ == NULL || buckets[i].size() < threshold_ || executor_->concurrency() <= 1) {
+      sequential_redistributor().redistribute(buckets, buckets_min, i, last);
+      return;
+    }
+
+    static constexpr size_t kNumBuckets = std::tuple_size<BucketsMin>::value;
+    typename Buckets::value_type &src = buckets[i];
+    const size_t n = src.size();
+    const size_t num_chunks = executor_->concurrency();
+    const size_t chunk_size = (n + num_chunks - 1) / num_chunks;
+
+    // counts[c][k]: the number of elements in chunk |c| going to bucket |k|,
+    // and then the position in bucket |k| where chunk |c| writes next.
+    std::vector<std::array<size_t, kNumBuckets>> counts(num_chunks);
+    std::vector<std::array<UnsignedKeyType, kNumBuckets>> mins(num_chunks);
+    executor_->run(num_chunks, [&](size_t c) {
+        counts[c].fill(0);
+        mins[c].fill(key_traits<UnsignedKeyType>::max());
+        const size_t e = std::min(n, (c + 1) * chunk_size);
+        for (size_t j = c * chunk_size; j < e; ++j) {
+          const UnsignedKeyType x = src[j].first;
+          const size_t k = find_bucket(x, last);
+          ++counts[c][k];
+          mins[c][k] = std::min(mins[c][k], x);
+        }
+      });
+
+    for (size_t k = 0; k < i; ++k) {
+      size_t offset = buckets[k].size();
+      for (size_t c = 0; c < num_chunks; ++c) {
+        const size_t count = counts[c][k];
+        counts[c][k] = offset;
+        offset += count;
+        buckets_min[k] = std::min(buckets_min[k], mins[c][k]);
+      }
+      buckets[k].resize(offset);
+    }
+
+    executor_->run(num_chunks, [&](size_t c) {
+        const size_t e = std::min(n, (c + 1) * chunk_size);
+        for (size_t j = c * chunk_size; j < e; ++j) {
+          const size_t k = find_bucket(src[j].first, last);
+          buckets[k][counts[c][k]++] = std::move(src[j]);
+        }
+      });
+  }
+
+ private:
+  Executor *executor_;
+  size_t threshold_;
+};
+}  // namespace internal
+
+// |pair_radix_heap| which redistributes buckets of at least |threshold|
+// elements in parallel by |Executor|, as |internal::parallel_redistributor|
+// does. |ValueType| must be default constructible.
+template<typename KeyType, typename ValueType, typename Executor = thread_pool_executor,
+         typename EncoderType = internal::encoder<KeyType>>
+class parallel_pair_radix_heap
+    : public pair_radix_heap<KeyType, ValueType, EncoderType,
+                             std::allocator<std::pair<KeyType, ValueType>>,
+                             internal::parallel_redistributor<Executor>> {
+ public:
+  typedef Executor executor_type;
+  typedef typename parallel_pair_radix_heap::encoder_type encoder_type;
+  typedef typename parallel_pair_radix_heap::redistributor_type redistributor_type;
+
+  explicit parallel_pair_radix_heap(executor_type &executor, size_t threshold = size_t(1) << 16)
+      : parallel_pair_radix_heap::pair_radix_heap(encoder_type(),
+                                                  redistributor_type(executor, threshold)) {}
+};
+
+// Per-thread |pair_radix_heap| shards placed on the NUMA node of their
+// owners. The shard of a thread is created by the thread itself at its first
+// push, so that its memory is first-touched on the local node. A thread pops
+// from its own shard, steals from other shards on the same node when its
+// shard runs dry, and crosses nodes only when the whole node runs dry.
+// As with |concurrent_radix_multiqueue|, popped keys are not always the
+// global minimum, and any key can be pushed.
+template<typename KeyType, typename ValueType, typename EncoderType = internal::encoder<KeyType>>
+class numa_sharded_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+
+  // Threads are identified by |0, ..., num_threads - 1|.
+  explicit numa_sharded_radix_heap(size_t num_threads)
+      : num_threads_(num_threads), shards_(new std::atomic<shard*>[num_threads]),
+        nodes_(new std::atomic<int>[num_threads]), size_(0), num_remote_steals_(0) {
+    for (size_t i = 0; i < num_threads_; ++i) {
+      shards_[i] = NULL;
+      nodes_[i] = -1;
+    }
+  }
+
+  ~numa_sharded_radix_heap() {
+    for (size_t i = 0; i < num_threads_; ++i) delete shards_[i].load();
+  }
+
+  void push(size_t thread_id, key_type key, const value_type &value) {
+    shard &s = local(thread_id);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.push(encoder_type::encode(key), value);
+    size_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Pops an element with a small key, preferring the own shard and then
+  // shards on the same node. Returns false if the heap is empty.
+  bool try_pop(size_t thread_id, key_type *key, value_type *value) {
+    const int node = local_node(thread_id);
+    while (size_.load(std::memory_order_relaxed) > 0) {
+      if (try_pop_from(thread_id, key, value)) return true;
+      if (try_pop_from(pick(thread_id, node, true), key, value)) return true;
+      const size_t victim = pick(thread_id, node, false);
+      if (try_pop_from(victim, key, value)) {
+        num_remote_steals_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+      std::this_thread::yield();
+    }
+    return false;
+  }
+
+  size_t size() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  // The NUMA node of the shard of a thread, or -1 if it is not created yet.
+  int node_of(size_t thread_id) const {
+    return nodes_[thread_id].load(std::memory_order_acquire);
+  }
+
+  // The number of elements popped from shards on other nodes.
+  size_t num_remote_steals() const {
+    return num_remote_steals_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  typedef internal::locked_shard<unsigned_key_type, value_type> shard;
+
+  const size_t num_threads_;
+  std::unique_ptr<std::atomic<shard*>[]> shards_;
+  std::unique_ptr<std::atomic<int>[]> nodes_;
+  std::atomic<size_t> size_;
+  std::atomic<size_t> num_remote_steals_;
+
+  shard &local(size_t thread_id) {
+    assert(thread_id < num_threads_);
+    shard *s = shards_[thread_id].load(std::memory_order_acquire);
+    if (s == NULL) {
+      s = new shard();
+      nodes_[thread_id].store(internal::current_numa_node(), std::memory_order_release);
+      shards_[thread_id].store(s, std::memory_order_release);
+    }
+    return *s;
+  }
+
+  int local_node(size_t thread_id) {
+    local(thread_id);
+    return node_of(thread_id);
+  }
+
+  // The shard with the smallest top on the same node (or on other nodes).
+  size_t pick(size_t thread_id, int node, bool same_node) const {
+    size_t best = num_threads_;
+    unsigned_key_type best_top = shard::kEmpty;
+    for (size_t i = 0; i < num_threads_; ++i) {
+      const shard *s = shards_[i].load(std::memory_order_acquire);
+      if (i == thread_id || s == NULL || (node_of(i) == node) != same_node) continue;
+      const unsigned_key_type t = s->top.load(std::memory_order_relaxed);
+      if (best == num_threads_ || t < best_top) {
+        best = i;
+        best_top = t;
+      }
+    }
+    return best;
+  }
+
+  bool try_pop_from(size_t i, key_type *key, value_type *value) {
+    if (i >= num_threads_) return false;
+    shard *s = shards_[i].load(std::memory_order_acquire);
+    if (s == NULL) return false;
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (s->empty()) return false;
+    unsigned_key_type x;
+    s->pop(&x, value);
+    *key = encoder_type::decode(x);
+    size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+};
+}  // namespace radix_heap
@@ -0,0 +1,108 @@
+/*
+  Measures the throughput of a timer-service workload, where producer threads
+  push deadlines slightly ahead of a moving clock and one consumer thread
+  pops them, with |concurrent_push_radix_heap| and with |pair_radix_heap|
+  protected by a mutex. Throughputs (pushes and pops per second) are reported
+  for 1, 2, 4, ... producers up to max(4, the number of hardware threads).
+
+  Usage: benchmark_concurrent_push_main
+*/
+
+#include "radix_heap.h"
+#include "concurrent_radix_heap.h"
+#include <sys/time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+using namespace std;
+
+#define CHECK(expr)                                                     \
+  if (expr) {                                                           \
+  } else {                                                              \
+    fprintf(stderr, "CHECK Failed (%s:%d): %s\n",                       \
+            __FILE__, __LINE__, #expr);                                 \
+    exit(EXIT_FAILURE);                                                 \
+  }
+
+namespace {
+constexpr int kNumPushPerProducer = 1 << 20;
+constexpr int kMaxDelay = 1024;
+
+inline double current_time_sec() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// |pair_radix_heap| wrapped by a mutex. Keys less than the last popped key
+// are raised to it, as |pair_radix_heap| does not accept them.
+class locked_heap {
+ public:
+  locked_heap() : last_(0) {}
+
+  void push(uint64_t key, int value) {
+    lock_guard<mutex> lock(mutex_);
+    heap_.push(max(key, last_), value);
+  }
+
+  bool try_pop(uint64_t *key, int *value) {
+    lock_guard<mutex> lock(mutex_);
+    if (heap_.empty()) return false;
+    *key = last_ = heap_.top_key();
+    *value = heap_.top_value();
+    heap_.pop();
+    return true;
+  }
+
+ private:
+  mutex mutex_;
+  radix_heap::pair_radix_heap<uint64_t, int> heap_;
+  uint64_t last_;
+};
+
+// Returns pushes and pops per second.
+template<typename heap_t>
+double benchmark(int num_producers) {
+  heap_t h;
+  double t = current_time_sec();
+  vector<thread> producers;
+  for (int p = 0; p < num_producers; ++p) {
+    producers.emplace_back([&h]() {
+        for (int i = 0; i < kNumPushPerProducer; ++i) {
+          h.push(i + radix_heap::internal::thread_random() % kMaxDelay, i);
+        }
+      });
+  }
+
+  const size_t num_total = size_t(num_producers) * kNumPushPerProducer;
+  uint64_t key;
+  int value;
+  for (size_t num_popped = 0; num_popped < num_total; ) {
+    if (h.try_pop(&key, &value)) ++num_popped;
+  }
+  for (auto &th : producers) th.join();
+  t = current_time_sec() - t;
+  CHECK(!h.try_pop(&key, &value));
+  return 2 * num_total / t;
+}
+}  // namespace
+
+int main() {
+  cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+  cout.imbue(std::locale(""));
+
+  vector<int> num_producers;
+  const int n = max(4u, thread::hardware_concurrency());
+  for (int i = 1; i < n; i *= 2) num_producers.push_back(i);
+  num_producers.push_back(n);
+
+  cout << "#Producers\tconcurrent-push(ops/s)\tmutex(ops/s)" << endl;
+  for (int p : num_producers) {
+    cout << p
+         << "\t" << benchmark<radix_heap::concurrent_push_radix_heap<uint64_t, int>>(p)
+         << "\t" << benchmark<locked_heap>(p) << endl;
+  }
+  return 0;
+}
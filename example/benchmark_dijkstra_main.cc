@@ -2,17 +2,54 @@
   Conducts Dijkstra's SSSP algorithm by using |radix_heap| and |std::priority_queue|.
   Reads graphs in the DIMACS format (http://www.dis.uniroma1.it/challenge9/format.shtml).
   100 Sources are randomly selected and the average times are reported.
+
+  Usage: benchmark_dijkstra_main GRAPH [MODE]
+  MODE is one of the following:
+    (none)    Overall and workload times of rheap and stl.
+    hugepage  Overall times and dTLB load misses of rheap with and without
+              |huge_page_allocator|.
+    multiqueue  Overall times of parallel label-correcting search with
+                |concurrent_radix_multiqueue| for 1, 2, 4, ..., 64 threads.
+    delta     Overall times of parallel delta-stepping for 1, 2, 4, ...
+              threads up to the number of hardware threads.
+    threads   Queries per second and latency percentiles of independent
+              queries from many threads, each reusing its heap and
+              workspace, for 1, 2, 4, ... threads up to the number of
+              hardware threads.
+    steal     Times per source of computing the sum of distances from every
+              source, with sources statically partitioned among threads and
+              scheduled by |work_stealing_executor|, for 1, 2, 4, ...
+              threads up to the number of hardware threads.
+    moves     Overall times and moves of elements between buckets per push
+              of rheap with weights as doubles, encoded by their raw bits
+              and by |quantized_encoder|.
+    numa      Overall times and cross-node steals of parallel label-correcting
+              search with |numa_sharded_radix_heap| and threads pinned to
+              CPUs, for 1, 2, 4, ... threads up to the number of hardware
+              threads.
 */
 
 #include "radix_heap.h"
+#include "huge_page_allocator.h"
+#include "concurrent_radix_heap.h"
 #include <sys/time.h>
 #include <unistd.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <limits>
 #include <queue>
 #include <iostream>
 #include <iomanip>
+#include <atomic>
+#include <thread>
 using namespace std;
 
 typedef int vertex_t;
@@ -44,6 +81,51 @@ inline double current_time_sec() {
   return tv.tv_sec + tv.tv_usec * 1e-6;
 }
 
+// Counts dTLB load misses of this process by perf_event_open(2).
+// |read| returns -1 if the counter is not available.
+class dtlb_miss_counter {
+ public:
+  dtlb_miss_counter() : fd_(-1) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~dtlb_miss_counter() {
+    if (fd_ >= 0) close(fd_);
+  }
+
+  void start() {
+#ifdef __linux__
+    if (fd_ < 0) return;
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  long long read() {
+    long long count = -1;
+#ifdef __linux__
+    if (fd_ < 0) return -1;
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    if (::read(fd_, &count, sizeof(count)) != sizeof(count)) return -1;
+#endif
+    return count;
+  }
+
+ private:
+  int fd_;
+};
+
 void read_header(istream &ifs, vertex_t *num_vs, size_t *num_es) {
   string line;
   CHECK(getline(ifs, line));
@@ -105,11 +187,12 @@ vector<weight_t> benchmark_dijkstra_stlpque(const graph_t &g, vertex_t s) {
   return pot;
 }
 
+template<typename heap_t = radix_heap::pair_radix_heap<weight_t, vertex_t>>
 vector<weight_t> benchmark_dijkstra_rheap(const graph_t &g, vertex_t s) {
   vector<weight_t> pot(g.size(), numeric_limits<weight_t>::max());
   pot[s] = 0;
 
-  radix_heap::pair_radix_heap<weight_t, vertex_t> que;
+  heap_t que;
   que.emplace(0, s);
 
   while (!que.empty()) {
@@ -131,6 +214,309 @@ vector<weight_t> benchmark_dijkstra_rheap(const graph_t &g, vertex_t s) {
   return pot;
 }
 
+// Parallel label-correcting variant. Since the queue is relaxed, a vertex may
+// be popped before its distance is final and is then scanned again later.
+vector<weight_t> benchmark_dijkstra_multiqueue(const graph_t &g, vertex_t s, int num_threads) {
+  unique_ptr<atomic<weight_t>[]> pot(new atomic<weight_t>[g.size()]);
+  for (size_t v = 0; v < g.size(); ++v) pot[v] = numeric_limits<weight_t>::max();
+  pot[s] = 0;
+
+  radix_heap::concurrent_radix_multiqueue<weight_t, vertex_t> que(num_threads);
+  // The number of pushed entries whose scan has not finished.
+  atomic<size_t> num_pending(1);
+  que.push(0, s);
+
+  auto worker = [&]() {
+    weight_t p;
+    vertex_t v;
+    for (;;) {
+      if (!que.try_pop(&p, &v)) {
+        if (num_pending.load() == 0) return;
+        this_thread::yield();
+        continue;
+      }
+      if (p <= pot[v].load(memory_order_relaxed)) {
+        for (const auto &e : g[v]) {
+          vertex_t tv = e.first;
+          weight_t tp = p + e.second;
+          weight_t cp = pot[tv].load(memory_order_relaxed);
+          while (tp < cp) {
+            if (pot[tv].compare_exchange_weak(cp, tp)) {
+              num_pending.fetch_add(1);
+              que.push(tp, tv);
+              break;
+            }
+          }
+        }
+      }
+      num_pending.fetch_sub(1);
+    }
+  };
+
+  vector<thread> threads;
+  for (int i = 1; i < num_threads; ++i) threads.emplace_back(worker);
+  worker();
+  for (auto &t : threads) t.join();
+
+  vector<weight_t> res(g.size());
+  for (size_t v = 0; v < g.size(); ++v) res[v] = pot[v];
+  return res;
+}
+
+// Pins the calling thread to |cpu|. Returns false if it is not supported.
+bool pin_current_thread(int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+
+// The same search as |benchmark_dijkstra_multiqueue| with a queue sharded
+// per thread and placed on the NUMA node of each thread. The number of
+// elements stolen across nodes is stored in |*num_remote_steals|.
+vector<weight_t> benchmark_dijkstra_numa(const graph_t &g, vertex_t s, int num_threads,
+                                         size_t *num_remote_steals) {
+  unique_ptr<atomic<weight_t>[]> pot(new atomic<weight_t>[g.size()]);
+  for (size_t v = 0; v < g.size(); ++v) pot[v] = numeric_limits<weight_t>::max();
+  pot[s] = 0;
+
+  radix_heap::numa_sharded_radix_heap<weight_t, vertex_t> que(num_threads);
+  atomic<size_t> num_pending(1);
+
+  const int num_cpus = max(1u, thread::hardware_concurrency());
+  auto worker = [&](int thread_id) {
+    pin_current_thread(thread_id % num_cpus);
+    // Shards are allocated by their owners after pinning.
+    if (thread_id == 0) que.push(0, 0, s);
+    weight_t p;
+    vertex_t v;
+    for (;;) {
+      if (!que.try_pop(thread_id, &p, &v)) {
+        if (num_pending.load() == 0) return;
+        this_thread::yield();
+        continue;
+      }
+      if (p <= pot[v].load(memory_order_relaxed)) {
+        for (const auto &e : g[v]) {
+          vertex_t tv = e.first;
+          weight_t tp = p + e.second;
+          weight_t cp = pot[tv].load(memory_order_relaxed);
+          while (tp < cp) {
+            if (pot[tv].compare_exchange_weak(cp, tp)) {
+              num_pending.fetch_add(1);
+              que.push(thread_id, tp, tv);
+              break;
+            }
+          }
+        }
+      }
+      num_pending.fetch_sub(1);
+    }
+  };
+
+  // Every worker runs in its own thread so that the main thread stays unpinned.
+  vector<thread> threads;
+  for (int i = 0; i < num_threads; ++i) threads.emplace_back(worker, i);
+  for (auto &t : threads) t.join();
+  *num_remote_steals = que.num_remote_steals();
+
+  vector<weight_t> res(g.size());
+  for (size_t v = 0; v < g.size(); ++v) res[v] = pot[v];
+  return res;
+}
+
+// Parallel delta-stepping [Meyer and Sanders, 2003]. Bucket |i| holds
+// vertices whose tentative distances |d| satisfy |(e(d) - e(0)) >> log_delta == i|,
+// where |e| is the order-preserving encoding of |radix_heap|. Each phase
+// takes a whole bucket, relaxes its light edges in parallel until the bucket
+// stays empty, and then relaxes the heavy edges of the settled vertices.
+// Improved vertices are collected in per-thread buffers and merged into the
+// buckets after each parallel step.
+class delta_stepping {
+ public:
+  delta_stepping(const graph_t &g, radix_heap::thread_pool_executor *executor)
+      : g_(g), executor_(executor), pot_(new atomic<weight_t>[g.size()]),
+        buffers_(executor->concurrency()) {
+    // A power of two close to the average edge weight.
+    double sum = 0;
+    size_t num_es = 0;
+    for (const auto &es : g) {
+      for (const auto &e : es) sum += e.second, ++num_es;
+    }
+    log_delta_ = 0;
+    while (num_es > 0 && (uint64_t(1) << (log_delta_ + 1)) <= sum / num_es) ++log_delta_;
+  }
+
+  vector<weight_t> run(vertex_t s) {
+    for (size_t v = 0; v < g_.size(); ++v) pot_[v] = numeric_limits<weight_t>::max();
+    buckets_.clear();
+    pot_[s] = 0;
+    add(s, 0);
+
+    vector<vertex_t> frontier, settled;
+    for (size_t b = 0; b < buckets_.size(); ++b) {
+      settled.clear();
+      while (!buckets_[b].empty()) {
+        frontier.clear();
+        for (vertex_t v : buckets_[b]) {
+          if (bucket_of(pot_[v].load(memory_order_relaxed)) == b) frontier.push_back(v);
+        }
+        buckets_[b].clear();
+        sort(frontier.begin(), frontier.end());
+        frontier.erase(unique(frontier.begin(), frontier.end()), frontier.end());
+        relax(frontier, true);
+        settled.insert(settled.end(), frontier.begin(), frontier.end());
+      }
+      relax(settled, false);
+    }
+
+    vector<weight_t> res(g_.size());
+    for (size_t v = 0; v < g_.size(); ++v) res[v] = pot_[v];
+    return res;
+  }
+
+ private:
+  typedef radix_heap::internal::encoder<weight_t> encoder_type;
+
+  const graph_t &g_;
+  radix_heap::thread_pool_executor *executor_;
+  unique_ptr<atomic<weight_t>[]> pot_;
+  int log_delta_;
+  vector<vector<vertex_t>> buckets_;
+  vector<vector<pair<vertex_t, weight_t>>> buffers_;
+
+  size_t bucket_of(weight_t d) const {
+    return (encoder_type::encode(d) - encoder_type::encode(0)) >> log_delta_;
+  }
+
+  void add(vertex_t v, weight_t d) {
+    const size_t b = bucket_of(d);
+    if (b >= buckets_.size()) buckets_.resize(b + 1);
+    buckets_[b].push_back(v);
+  }
+
+  void relax(const vector<vertex_t> &vs, bool light) {
+    const weight_t delta = weight_t(1) << log_delta_;
+    const size_t num_chunks = buffers_.size();
+    const size_t chunk_size = (vs.size() + num_chunks - 1) / num_chunks;
+    executor_->run(num_chunks, [&](size_t c) {
+        vector<pair<vertex_t, weight_t>> &buffer = buffers_[c];
+        const size_t end = min(vs.size(), (c + 1) * chunk_size);
+        for (size_t i = c * chunk_size; i < end; ++i) {
+          const vertex_t v = vs[i];
+          const weight_t p = pot_[v].load(memory_order_relaxed);
+          for (const auto &e : g_[v]) {
+            if ((e.second < delta) != light) continue;
+            const vertex_t tv = e.first;
+            const weight_t tp = p + e.second;
+            weight_t cp = pot_[tv].load(memory_order_relaxed);
+            while (tp < cp) {
+              if (pot_[tv].compare_exchange_weak(cp, tp, memory_order_relaxed)) {
+                buffer.emplace_back(tv, tp);
+                break;
+              }
+            }
+          }
+        }
+      });
+
+    for (auto &buffer : buffers_) {
+      for (const auto &u : buffer) {
+        if (pot_[u.first].load(memory_order_relaxed) == u.second) add(u.first, u.second);
+      }
+      buffer.clear();
+    }
+  }
+};
+
+// The sum of the distances to reachable vertices.
+int64_t distance_sum(const vector<weight_t> &pot) {
+  int64_t res = 0;
+  for (weight_t p : pot) {
+    if (p != numeric_limits<weight_t>::max()) res += p;
+  }
+  return res;
+}
+
+// Dijkstra's algorithm reusing the heap and the distance array across
+// queries. Only entries touched by the previous query are reset.
+class dijkstra_workspace {
+ public:
+  explicit dijkstra_workspace(const graph_t &g)
+      : g_(g), pot_(g.size(), numeric_limits<weight_t>::max()) {}
+
+  const vector<weight_t> &run(vertex_t s) {
+    for (vertex_t v : touched_) pot_[v] = numeric_limits<weight_t>::max();
+    touched_.clear();
+    que_.clear();
+
+    pot_[s] = 0;
+    touched_.push_back(s);
+    que_.emplace(0, s);
+
+    while (!que_.empty()) {
+      vertex_t v = que_.top_value();
+      weight_t p = que_.top_key();
+      que_.pop();
+      if (p > pot_[v]) continue;
+
+      for (const auto &e : g_[v]) {
+        vertex_t tv = e.first;
+        weight_t tp = p + e.second;
+        if (tp < pot_[tv]) {
+          if (pot_[tv] == numeric_limits<weight_t>::max()) touched_.push_back(tv);
+          pot_[tv] = tp;
+          que_.emplace(tp, tv);
+        }
+      }
+    }
+    return pot_;
+  }
+
+ private:
+  const graph_t &g_;
+  radix_heap::pair_radix_heap<weight_t, vertex_t> que_;
+  vector<weight_t> pot_;
+  vector<vertex_t> touched_;
+};
+
+// Sums of the distances to reachable vertices from each source, as in
+// closeness centrality. Sources are split into equal contiguous blocks, one
+// per thread, and thread |t| uses workspace |(*wss)[t]|.
+vector<int64_t> distance_sums_static(vector<dijkstra_workspace> *wss,
+                                     const vector<vertex_t> &ss) {
+  const int num_threads = wss->size();
+  vector<int64_t> res(ss.size());
+  auto worker = [&](int t) {
+    dijkstra_workspace &ws = (*wss)[t];
+    for (size_t i = ss.size() * t / num_threads; i < ss.size() * (t + 1) / num_threads; ++i) {
+      res[i] = distance_sum(ws.run(ss[i]));
+    }
+  };
+  vector<thread> threads;
+  for (int t = 1; t < num_threads; ++t) threads.emplace_back(worker, t);
+  worker(0);
+  for (auto &th : threads) th.join();
+  return res;
+}
+
+// The same as |distance_sums_static| with sources scheduled by work stealing.
+// Worker |w| uses workspace |(*wss)[w]|.
+vector<int64_t> distance_sums_steal(radix_heap::work_stealing_executor *executor,
+                                    vector<dijkstra_workspace> *wss,
+                                    const vector<vertex_t> &ss) {
+  vector<int64_t> res(ss.size());
+  executor->run_with_worker(ss.size(), 1, [&](size_t w, size_t i) {
+      res[i] = distance_sum((*wss)[w].run(ss[i]));
+    });
+  return res;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Pure priority queue performance by Dijkstra's algorithm workloads
 ////////////////////////////////////////////////////////////////////////////////
@@ -204,6 +590,303 @@ void benchmark_workload_rheap(const workload_t &wl) {
     }
   }
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// Bucket moves with floating-point keys
+////////////////////////////////////////////////////////////////////////////////
+
+// Weights as doubles in tenths, e.g., seconds for travel times given in
+// deciseconds, quantized to this precision by |quantized_encoder|.
+constexpr double kWeightScale = 0.1;
+
+size_t num_label_moves = 0;
+
+// A vertex with its tentative distance, counting its moves. The move
+// constructor is not noexcept, so vectors copy elements on reallocation, and
+// only moves between buckets are counted.
+struct counted_label {
+  vertex_t v;
+  double p;
+
+  counted_label(vertex_t v, double p) : v(v), p(p) {}
+  counted_label(const counted_label &l) = default;
+  counted_label(counted_label &&l) : v(l.v), p(l.p) {
+    ++num_label_moves;
+  }
+  counted_label &operator=(const counted_label &l) = default;
+};
+
+// Stale entries are detected by the distances in values, which are not
+// rounded by encoders.
+template<typename heap_t>
+vector<double> benchmark_dijkstra_double(const graph_t &g, vertex_t s, heap_t &que,
+                                         size_t *num_pushes) {
+  vector<double> pot(g.size(), numeric_limits<double>::max());
+  pot[s] = 0;
+  que.clear();
+  que.push(0, counted_label(s, 0));
+  *num_pushes = 1;
+
+  while (!que.empty()) {
+    const counted_label l = que.top_value();
+    que.pop();
+    if (l.p > pot[l.v]) continue;
+
+    for (const auto &e : g[l.v]) {
+      const counted_label t(e.first, l.p + e.second * kWeightScale);
+      if (t.p < pot[t.v]) {
+        pot[t.v] = t.p;
+        que.push(t.p, t);
+        ++*num_pushes;
+      }
+    }
+  }
+  return pot;
+}
+
+// Prints the average time and the number of moves per push.
+template<typename heap_t>
+void run_moves_with(const graph_t &g, const vector<vertex_t> &ss, heap_t &que) {
+  size_t num_pushes = 0, n;
+  num_label_moves = 0;
+  double t = current_time_sec();
+  for (vertex_t s : ss) {
+    benchmark_dijkstra_double(g, s, que, &n);
+    num_pushes += n;
+  }
+  t = current_time_sec() - t;
+  cout << "\t" << t / ss.size() << "\t" << double(num_label_moves) / num_pushes;
+}
+
+void run_moves(const graph_t &g, const vector<vertex_t> &ss) {
+  typedef radix_heap::quantized_encoder<double, uint32_t> encoder_t;
+  radix_heap::pair_radix_heap<double, counted_label> raw;
+  radix_heap::pair_radix_heap<double, counted_label, encoder_t> quantized(encoder_t(0, kWeightScale));
+
+  for (int i = 0; i < 10; ++i) {
+    vertex_t s = ss[i % ss.size()];
+    const vector<weight_t> p0 = benchmark_dijkstra_rheap(g, s);
+    size_t n;
+    const vector<double> p1 = benchmark_dijkstra_double(g, s, raw, &n);
+    const vector<double> p2 = benchmark_dijkstra_double(g, s, quantized, &n);
+    for (size_t v = 0; v < g.size(); ++v) {
+      if (p0[v] == numeric_limits<weight_t>::max()) continue;
+      const double p = p0[v] * kWeightScale;
+      CHECK(fabs(p1[v] - p) <= 1e-9 * (1 + p));
+      CHECK(fabs(p2[v] - p) <= 1e-9 * (1 + p));
+    }
+  }
+  run_moves_with(g, ss, raw);
+  run_moves_with(g, ss, quantized);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Modes
+////////////////////////////////////////////////////////////////////////////////
+
+typedef radix_heap::pair_radix_heap
+<weight_t, vertex_t, radix_heap::internal::encoder<weight_t>,
+ radix_heap::huge_page_allocator<pair<weight_t, vertex_t>>> huge_page_heap_t;
+
+void run_default(const graph_t &g, const vector<vertex_t> &ss) {
+  const double num_sources = ss.size();
+
+  // Benchmark (overall)
+  {
+    {
+      double t = current_time_sec();
+      for (vertex_t s : ss) {
+        benchmark_dijkstra_rheap(g, s);
+      }
+      cout << "\t" << (current_time_sec() - t) / num_sources;
+    }
+    {
+      double t = current_time_sec();
+      for (vertex_t s : ss) {
+        benchmark_dijkstra_stlpque(g, s);
+      }
+      cout << "\t" << (current_time_sec() - t) / num_sources;
+    }
+  }
+
+  // Benchmark (workload)
+  {
+    workload_t workload;
+    for (vertex_t s : ss) {
+      add_workload(g, s, &workload);
+    }
+    {
+      double t = current_time_sec();
+      benchmark_workload_rheap(workload);
+      cout << "\t" << (current_time_sec() - t) / num_sources;
+    }
+    {
+      double t = current_time_sec();
+      benchmark_workload_stlpque(workload);
+      cout << "\t" << (current_time_sec() - t) / num_sources;
+    }
+  }
+}
+
+template<typename heap_t>
+void run_dtlb(const graph_t &g, const vector<vertex_t> &ss) {
+  dtlb_miss_counter counter;
+  counter.start();
+  double t = current_time_sec();
+  for (vertex_t s : ss) {
+    benchmark_dijkstra_rheap<heap_t>(g, s);
+  }
+  t = current_time_sec() - t;
+  long long misses = counter.read();
+  cout << "\t" << t / ss.size() << "\t";
+  if (misses < 0) cout << "n/a";
+  else cout << misses / (long long)ss.size();
+}
+
+void run_hugepage(const graph_t &g, const vector<vertex_t> &ss) {
+  for (int i = 0; i < 10; ++i) {
+    vertex_t s = ss[i % ss.size()];
+    CHECK(benchmark_dijkstra_rheap(g, s) == benchmark_dijkstra_rheap<huge_page_heap_t>(g, s));
+  }
+  run_dtlb<radix_heap::pair_radix_heap<weight_t, vertex_t>>(g, ss);
+  run_dtlb<huge_page_heap_t>(g, ss);
+}
+
+constexpr int kMaxNumThreads = 64;
+
+void run_multiqueue(const graph_t &g, const vector<vertex_t> &ss) {
+  {
+    double t = current_time_sec();
+    for (vertex_t s : ss) {
+      benchmark_dijkstra_rheap(g, s);
+    }
+    cout << "\t" << (current_time_sec() - t) / ss.size();
+  }
+  for (int num_threads = 1; num_threads <= kMaxNumThreads; num_threads *= 2) {
+    CHECK(benchmark_dijkstra_multiqueue(g, ss[0], num_threads) == benchmark_dijkstra_rheap(g, ss[0]));
+    double t = current_time_sec();
+    for (vertex_t s : ss) {
+      benchmark_dijkstra_multiqueue(g, s, num_threads);
+    }
+    cout << "\t" << (current_time_sec() - t) / ss.size();
+  }
+}
+
+vector<int> hardware_num_threads() {
+  vector<int> res;
+  const int n = max(1u, thread::hardware_concurrency());
+  for (int i = 1; i < n; i *= 2) res.push_back(i);
+  res.push_back(n);
+  return res;
+}
+
+// Speedups are relative to sequential Dijkstra's algorithm with |pair_radix_heap|.
+void run_delta(const graph_t &g, const vector<vertex_t> &ss) {
+  double sequential_time = current_time_sec();
+  for (vertex_t s : ss) {
+    benchmark_dijkstra_rheap(g, s);
+  }
+  sequential_time = current_time_sec() - sequential_time;
+  cout << "\t" << sequential_time / ss.size();
+
+  for (int num_threads : hardware_num_threads()) {
+    radix_heap::thread_pool_executor executor(num_threads);
+    delta_stepping ds(g, &executor);
+    for (int i = 0; i < 10; ++i) {
+      vertex_t s = ss[i % ss.size()];
+      vector<weight_t> p1 = benchmark_dijkstra_rheap(g, s);
+      vector<weight_t> p2 = ds.run(s);
+      CHECK(p1 == p2);
+    }
+    double t = current_time_sec();
+    for (vertex_t s : ss) {
+      ds.run(s);
+    }
+    t = current_time_sec() - t;
+    cout << "\t" << t / ss.size() << "\t" << sequential_time / t;
+  }
+}
+
+void run_steal(const graph_t &g, const vector<vertex_t> &ss) {
+  vector<dijkstra_workspace> sequential_wss(1, dijkstra_workspace(g));
+  const vector<int64_t> expected = distance_sums_static(&sequential_wss, ss);
+  for (int num_threads : hardware_num_threads()) {
+    {
+      vector<dijkstra_workspace> wss(num_threads, dijkstra_workspace(g));
+      CHECK(distance_sums_static(&wss, ss) == expected);
+      double t = current_time_sec();
+      distance_sums_static(&wss, ss);
+      cout << "\t" << (current_time_sec() - t) / ss.size();
+    }
+    {
+      radix_heap::work_stealing_executor executor(num_threads);
+      vector<dijkstra_workspace> wss(num_threads, dijkstra_workspace(g));
+      CHECK(distance_sums_steal(&executor, &wss, ss) == expected);
+      double t = current_time_sec();
+      distance_sums_steal(&executor, &wss, ss);
+      cout << "\t" << (current_time_sec() - t) / ss.size();
+    }
+  }
+}
+
+void run_numa(const graph_t &g, const vector<vertex_t> &ss) {
+  {
+    double t = current_time_sec();
+    for (vertex_t s : ss) {
+      benchmark_dijkstra_rheap(g, s);
+    }
+    cout << "\t" << (current_time_sec() - t) / ss.size();
+  }
+  for (int num_threads : hardware_num_threads()) {
+    size_t num_remote_steals = 0, total_remote_steals = 0;
+    CHECK(benchmark_dijkstra_numa(g, ss[0], num_threads, &num_remote_steals) ==
+          benchmark_dijkstra_rheap(g, ss[0]));
+    double t = current_time_sec();
+    for (vertex_t s : ss) {
+      benchmark_dijkstra_numa(g, s, num_threads, &num_remote_steals);
+      total_remote_steals += num_remote_steals;
+    }
+    cout << "\t" << (current_time_sec() - t) / ss.size()
+         << "\t" << total_remote_steals / ss.size();
+  }
+}
+
+void run_threads(const graph_t &g, const vector<vertex_t> &ss) {
+  {
+    dijkstra_workspace ws(g);
+    for (int i = 0; i < 10; ++i) {
+      vertex_t s = ss[i % ss.size()];
+      CHECK(ws.run(s) == benchmark_dijkstra_rheap(g, s));
+    }
+  }
+
+  for (int num_threads : hardware_num_threads()) {
+    // Every thread answers queries from the shared list until it runs out.
+    const size_t num_queries = ss.size() * num_threads;
+    vector<double> latencies(num_queries);
+    atomic<size_t> next(0);
+    vector<dijkstra_workspace> wss(num_threads, dijkstra_workspace(g));
+    auto worker = [&](int w) {
+      dijkstra_workspace &ws = wss[w];
+      for (size_t i; (i = next.fetch_add(1)) < num_queries; ) {
+        double t = current_time_sec();
+        ws.run(ss[i % ss.size()]);
+        latencies[i] = current_time_sec() - t;
+      }
+    };
+
+    double t = current_time_sec();
+    vector<thread> threads;
+    for (int i = 0; i < num_threads; ++i) threads.emplace_back(worker, i);
+    for (auto &th : threads) th.join();
+    t = current_time_sec() - t;
+
+    sort(latencies.begin(), latencies.end());
+    cout << "\t" << num_queries / t
+         << "\t" << latencies[num_queries / 2]
+         << "\t" << latencies[num_queries * 99 / 100];
+  }
+}
 }  // namespace
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -213,12 +896,59 @@ void benchmark_workload_rheap(const workload_t &wl) {
 int main(int argc, char **argv) {
   cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
   cout.imbue(std::locale(""));
-  cout << "#File\tV\tE\trheap(overall)\tstl(overall)\trheap(workload)\tstl(workload)" << endl;
+
+  CHECK(argc == 2 || argc == 3);
+  const string mode = argc == 3 ? argv[2] : "";
+  if (mode == "") {
+    cout << "#File\tV\tE\trheap(overall)\tstl(overall)\trheap(workload)\tstl(workload)" << endl;
+  } else if (mode == "hugepage") {
+    cout << "#File\tV\tE\trheap(overall)\trheap(dTLB-miss)"
+        "\trheap-hugepage(overall)\trheap-hugepage(dTLB-miss)" << endl;
+  } else if (mode == "multiqueue") {
+    cout << "#File\tV\tE\trheap(overall)";
+    for (int num_threads = 1; num_threads <= kMaxNumThreads; num_threads *= 2) {
+      cout << "\tmultiqueue-" << num_threads << "(overall)";
+    }
+    cout << endl;
+  } else if (mode == "delta") {
+    cout << "#File\tV\tE\trheap(overall)";
+    for (int num_threads : hardware_num_threads()) {
+      cout << "\tdelta-" << num_threads << "(overall)"
+           << "\tdelta-" << num_threads << "(speedup)";
+    }
+    cout << endl;
+  } else if (mode == "steal") {
+    cout << "#File\tV\tE";
+    for (int num_threads : hardware_num_threads()) {
+      cout << "\tstatic-" << num_threads << "(overall)"
+           << "\tsteal-" << num_threads << "(overall)";
+    }
+    cout << endl;
+  } else if (mode == "numa") {
+    cout << "#File\tV\tE\trheap(overall)";
+    for (int num_threads : hardware_num_threads()) {
+      cout << "\tnuma-" << num_threads << "(overall)"
+           << "\tnuma-" << num_threads << "(remote-steals)";
+    }
+    cout << endl;
+  } else if (mode == "moves") {
+    cout << "#File\tV\tE\trheap-double(overall)\trheap-double(moves/push)"
+        "\trheap-quantized(overall)\trheap-quantized(moves/push)" << endl;
+  } else if (mode == "threads") {
+    cout << "#File\tV\tE";
+    for (int num_threads : hardware_num_threads()) {
+      cout << "\tthreads-" << num_threads << "(qps)"
+           << "\tthreads-" << num_threads << "(p50)"
+           << "\tthreads-" << num_threads << "(p99)";
+    }
+    cout << endl;
+  } else {
+    CHECK(!"unknown mode");
+  }
 
   // Load
   graph_t g;
   {
-    CHECK(argc == 2);
     ifstream ifs(argv[1]);
     CHECK(ifs);
     ifs.sync_with_stdio(false);
@@ -254,47 +984,21 @@ int main(int argc, char **argv) {
     }
   }
 
-  // Benchmark (overall)
+  // Benchmark
   constexpr int kNumBenchmarkSources = 100;
   vector<vertex_t> ss(kNumBenchmarkSources);
   for (int i = 0; i < kNumBenchmarkSources; ++i) {
     ss[i] = xorshift64() % g.size();
   }
 
-  {
-    {
-      double t = current_time_sec();
-      for (vertex_t s : ss) {
-        benchmark_dijkstra_rheap(g, s);
-      }
-      cout << "\t" << (current_time_sec() - t) / kNumBenchmarkSources;
-    }
-    {
-      double t = current_time_sec();
-      for (vertex_t s : ss) {
-        benchmark_dijkstra_stlpque(g, s);
-      }
-      cout << "\t" << (current_time_sec() - t) / kNumBenchmarkSources;
-    }
-  }
-
-  // Benchmark (workload)
-  {
-    workload_t workload;
-    for (vertex_t s : ss) {
-      add_workload(g, s, &workload);
-    }
-    {
-      double t = current_time_sec();
-      benchmark_workload_rheap(workload);
-      cout << "\t" << (current_time_sec() - t) / kNumBenchmarkSources;
-    }
-    {
-      double t = current_time_sec();
-      benchmark_workload_stlpque(workload);
-      cout << "\t" << (current_time_sec() - t) / kNumBenchmarkSources;
-    }
-  }
+  if (mode == "") run_default(g, ss);
+  else if (mode == "hugepage") run_hugepage(g, ss);
+  else if (mode == "multiqueue") run_multiqueue(g, ss);
+  else if (mode == "delta") run_delta(g, ss);
+  else if (mode == "threads") run_threads(g, ss);
+  else if (mode == "steal") run_steal(g, ss);
+  else if (mode == "numa") run_numa(g, ss);
+  else if (mode == "moves") run_moves(g, ss);
 
   cout << endl;
   return 0;
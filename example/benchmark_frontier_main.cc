@@ -0,0 +1,239 @@
+/*
+  Conducts Dijkstra's SSSP algorithm by |pair_radix_heap| sequentially and
+  with equal-key frontiers relaxed in parallel. On graphs with small integer
+  weights, many vertices share the minimum distance. |pop_top_group| takes
+  all of them at once, and they are scanned by a thread pool. Improved
+  vertices are collected in per-chunk buffers and merged back by
+  |push_range|.
+
+  Two kinds of synthetic graphs are used: a grid with random weights in
+  [1, 4] and a random graph with unit weights. 10 sources are randomly
+  selected and the average times are reported for 1, 2, 4, ... threads up to
+  the number of hardware threads, together with the speedup over the
+  sequential algorithm.
+
+  Usage: benchmark_frontier_main [GRID_SIDE]
+*/
+
+#include "radix_heap.h"
+#include "concurrent_radix_heap.h"
+#include <sys/time.h>
+#include <cstdlib>
+#include <cstdio>
+#include <limits>
+#include <iostream>
+#include <atomic>
+#include <thread>
+using namespace std;
+
+typedef int vertex_t;
+typedef int weight_t;
+typedef pair<vertex_t, weight_t> edge_t;
+typedef vector<vector<edge_t>> graph_t;
+
+#define CHECK(expr)                                                     \
+  if (expr) {                                                           \
+  } else {                                                              \
+    fprintf(stderr, "CHECK Failed (%s:%d): %s\n",                       \
+            __FILE__, __LINE__, #expr);                                 \
+    exit(EXIT_FAILURE);                                                 \
+  }
+
+namespace {
+// xorshift64* random generator [Vigna, 2014]
+uint64_t x = 123456789LL;
+uint64_t xorshift64() {
+  x ^= x >> 12;  // a
+  x ^= x << 25;  // b
+  x ^= x >> 27;  // c
+  return x * 2685821657736338717LL;
+}
+
+inline double current_time_sec() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Graphs
+////////////////////////////////////////////////////////////////////////////////
+
+// A |side| x |side| grid whose edges have random weights in [1, 4].
+graph_t make_grid(int side) {
+  graph_t g(side * side);
+  auto add = [&](vertex_t u, vertex_t v) {
+    const weight_t w = 1 + xorshift64() % 4;
+    g[u].emplace_back(v, w);
+    g[v].emplace_back(u, w);
+  };
+  for (int i = 0; i < side; ++i) {
+    for (int j = 0; j < side; ++j) {
+      if (i + 1 < side) add(i * side + j, (i + 1) * side + j);
+      if (j + 1 < side) add(i * side + j, i * side + j + 1);
+    }
+  }
+  return g;
+}
+
+// A random directed graph with unit weights.
+graph_t make_unit(vertex_t num_vs, size_t num_es) {
+  graph_t g(num_vs);
+  for (size_t i = 0; i < num_es; ++i) {
+    g[xorshift64() % num_vs].emplace_back(xorshift64() % num_vs, 1);
+  }
+  return g;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Algorithms
+////////////////////////////////////////////////////////////////////////////////
+
+vector<weight_t> dijkstra_sequential(const graph_t &g, vertex_t s) {
+  vector<weight_t> pot(g.size(), numeric_limits<weight_t>::max());
+  radix_heap::pair_radix_heap<weight_t, vertex_t> que;
+  pot[s] = 0;
+  que.push(0, s);
+
+  while (!que.empty()) {
+    vertex_t v = que.top_value();
+    weight_t p = que.top_key();
+    que.pop();
+    if (p > pot[v]) continue;
+
+    for (const auto &e : g[v]) {
+      vertex_t tv = e.first;
+      weight_t tp = p + e.second;
+      if (tp < pot[tv]) {
+        pot[tv] = tp;
+        que.push(tp, tv);
+      }
+    }
+  }
+  return pot;
+}
+
+// Dijkstra's algorithm scanning each equal-key frontier in parallel. Since
+// all weights are positive, vertices in a frontier cannot improve each other.
+class dijkstra_frontier {
+ public:
+  dijkstra_frontier(const graph_t &g, radix_heap::thread_pool_executor *executor)
+      : g_(g), executor_(executor), pot_(new atomic<weight_t>[g.size()]),
+        buffers_(executor->concurrency()) {}
+
+  vector<weight_t> run(vertex_t s) {
+    for (size_t v = 0; v < g_.size(); ++v) pot_[v] = numeric_limits<weight_t>::max();
+    pot_[s] = 0;
+    que_.clear();
+    que_.push(0, s);
+
+    vector<vertex_t> group;
+    while (!que_.empty()) {
+      group.clear();
+      const weight_t p = que_.pop_top_group(group);
+      // Drops stale entries. A vertex is pushed at most once with each key,
+      // since it is pushed only when its distance strictly decreases.
+      frontier_.clear();
+      for (vertex_t v : group) {
+        if (pot_[v].load(memory_order_relaxed) == p) frontier_.push_back(v);
+      }
+
+      const size_t num_chunks = frontier_.size() < kMinParallelSize ? 1 : buffers_.size();
+      executor_->run(num_chunks, [&](size_t c) {
+          const size_t b = frontier_.size() * c / num_chunks;
+          const size_t e = frontier_.size() * (c + 1) / num_chunks;
+          for (size_t i = b; i < e; ++i) scan(frontier_[i], p, &buffers_[c]);
+        });
+      for (size_t c = 0; c < num_chunks; ++c) {
+        que_.push_range(buffers_[c].begin(), buffers_[c].end());
+        buffers_[c].clear();
+      }
+    }
+
+    vector<weight_t> res(g_.size());
+    for (size_t v = 0; v < g_.size(); ++v) res[v] = pot_[v];
+    return res;
+  }
+
+ private:
+  // Frontiers smaller than this are scanned by the calling thread alone.
+  static constexpr size_t kMinParallelSize = 256;
+
+  const graph_t &g_;
+  radix_heap::thread_pool_executor *executor_;
+  unique_ptr<atomic<weight_t>[]> pot_;
+  radix_heap::pair_radix_heap<weight_t, vertex_t> que_;
+  vector<vertex_t> frontier_;
+  vector<vector<pair<weight_t, vertex_t>>> buffers_;
+
+  void scan(vertex_t v, weight_t p, vector<pair<weight_t, vertex_t>> *buffer) {
+    for (const auto &e : g_[v]) {
+      vertex_t tv = e.first;
+      weight_t tp = p + e.second;
+      weight_t cp = pot_[tv].load(memory_order_relaxed);
+      while (tp < cp) {
+        if (pot_[tv].compare_exchange_weak(cp, tp, memory_order_relaxed)) {
+          buffer->emplace_back(tp, tv);
+          break;
+        }
+      }
+    }
+  }
+};
+
+constexpr size_t dijkstra_frontier::kMinParallelSize;
+
+vector<int> hardware_num_threads() {
+  vector<int> res;
+  const int n = max(1u, thread::hardware_concurrency());
+  for (int i = 1; i < n; i *= 2) res.push_back(i);
+  res.push_back(n);
+  return res;
+}
+
+void benchmark(const char *name, const graph_t &g) {
+  constexpr int kNumSources = 10;
+  vector<vertex_t> ss(kNumSources);
+  for (int i = 0; i < kNumSources; ++i) ss[i] = xorshift64() % g.size();
+
+  size_t num_es = 0;
+  for (const auto &a : g) num_es += a.size();
+  cout << name << "\t" << g.size() << "\t" << num_es;
+
+  double seq;
+  {
+    double t = current_time_sec();
+    for (vertex_t s : ss) dijkstra_sequential(g, s);
+    seq = (current_time_sec() - t) / ss.size();
+    cout << "\t" << seq;
+  }
+  for (int num_threads : hardware_num_threads()) {
+    radix_heap::thread_pool_executor executor(num_threads);
+    dijkstra_frontier df(g, &executor);
+    CHECK(df.run(ss[0]) == dijkstra_sequential(g, ss[0]));
+    double t = current_time_sec();
+    for (vertex_t s : ss) df.run(s);
+    t = (current_time_sec() - t) / ss.size();
+    cout << "\t" << t << "\t" << seq / t;
+  }
+  cout << endl;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+
+  CHECK(argc == 1 || argc == 2);
+  const int side = argc == 2 ? atoi(argv[1]) : 1000;
+  CHECK(side > 0);
+
+  cout << "#Graph\tV\tE\tsequential";
+  for (int num_threads : hardware_num_threads()) {
+    cout << "\tfrontier-" << num_threads << "\tfrontier-" << num_threads << "(speedup)";
+  }
+  cout << endl;
+
+  benchmark("grid", make_grid(side));
+  benchmark("unit", make_unit(side * side, size_t(side) * side * 4));
+  return 0;
+}
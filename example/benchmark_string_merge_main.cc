@@ -0,0 +1,143 @@
+/*
+  Merges sorted runs of string keys, as in compactions of SSTables, by
+  |string_radix_heap| and |std::priority_queue<std::pair<std::string, int>>|.
+  Keys look like "user:00001234:5678", so keys close in order share long
+  prefixes. The heap holds the head of each run, and after a key is popped,
+  the next key of its run is pushed. Times are reported for 4, 16, 64, ...,
+  1024 runs with the same total number of keys.
+
+  Usage: benchmark_string_merge_main [NUM_KEYS]
+*/
+
+#include "string_radix_heap.h"
+#include <sys/time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <string>
+#include <iostream>
+using namespace std;
+
+#define CHECK(expr)                                                     \
+  if (expr) {                                                           \
+  } else {                                                              \
+    fprintf(stderr, "CHECK Failed (%s:%d): %s\n",                       \
+            __FILE__, __LINE__, #expr);                                 \
+    exit(EXIT_FAILURE);                                                 \
+  }
+
+namespace {
+// xorshift64* random generator [Vigna, 2014]
+uint64_t x = 123456789LL;
+uint64_t xorshift64() {
+  x ^= x >> 12;  // a
+  x ^= x << 25;  // b
+  x ^= x >> 27;  // c
+  return x * 2685821657736338717LL;
+}
+
+inline double current_time_sec() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+typedef vector<string> run_t;
+
+vector<run_t> make_runs(int num_runs, size_t num_keys) {
+  vector<run_t> runs(num_runs);
+  char buf[32];
+  for (size_t i = 0; i < num_keys; ++i) {
+    snprintf(buf, sizeof(buf), "user:%08d:%04d",
+             int(xorshift64() % (num_keys / 4 + 1)), int(xorshift64() % 10000));
+    runs[i % num_runs].push_back(buf);
+  }
+  for (auto &r : runs) sort(r.begin(), r.end());
+  return runs;
+}
+
+// Whether |order|, the run of each key in a merged order, takes all the keys
+// in non-decreasing order. Equal keys may come from runs in any order.
+bool is_merged(const vector<run_t> &runs, const vector<int> &order) {
+  vector<size_t> pos(runs.size(), 0);
+  const string *last = NULL;
+  for (int r : order) {
+    if (pos[r] == runs[r].size()) return false;
+    const string *key = &runs[r][pos[r]++];
+    if (last != NULL && *key < *last) return false;
+    last = key;
+  }
+  for (size_t r = 0; r < runs.size(); ++r) {
+    if (pos[r] != runs[r].size()) return false;
+  }
+  return true;
+}
+
+// Returns the run of each key in the merged order.
+vector<int> merge_rheap(const vector<run_t> &runs) {
+  vector<int> res;
+  vector<size_t> pos(runs.size(), 0);
+  radix_heap::string_radix_heap<int> que;
+  for (size_t r = 0; r < runs.size(); ++r) {
+    if (!runs[r].empty()) que.push(runs[r][0], r);
+  }
+
+  while (!que.empty()) {
+    const int r = que.top_value();
+    que.pop();
+    res.push_back(r);
+    if (++pos[r] < runs[r].size()) que.push(runs[r][pos[r]], r);
+  }
+  return res;
+}
+
+vector<int> merge_stlpque(const vector<run_t> &runs) {
+  vector<int> res;
+  vector<size_t> pos(runs.size(), 0);
+  typedef pair<string, int> queue_entry_t;
+  priority_queue<queue_entry_t, vector<queue_entry_t>, greater<queue_entry_t>> que;
+  for (size_t r = 0; r < runs.size(); ++r) {
+    if (!runs[r].empty()) que.emplace(runs[r][0], r);
+  }
+
+  while (!que.empty()) {
+    const int r = que.top().second;
+    que.pop();
+    res.push_back(r);
+    if (++pos[r] < runs[r].size()) que.emplace(runs[r][pos[r]], r);
+  }
+  return res;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+
+  CHECK(argc == 1 || argc == 2);
+  const size_t num_keys = argc == 2 ? atol(argv[1]) : 1000000;
+  CHECK(num_keys > 0);
+
+  cout << "#Runs\tKeys\trheap(overall)\tstl(overall)" << endl;
+  for (int num_runs = 4; num_runs <= 1024; num_runs *= 4) {
+    const vector<run_t> runs = make_runs(num_runs, num_keys);
+    cout << num_runs << "\t" << num_keys;
+
+    vector<int> r1, r2;
+    {
+      double t = current_time_sec();
+      r1 = merge_rheap(runs);
+      cout << "\t" << current_time_sec() - t;
+    }
+    {
+      double t = current_time_sec();
+      r2 = merge_stlpque(runs);
+      cout << "\t" << current_time_sec() - t;
+    }
+    CHECK(is_merged(runs, r1));
+    CHECK(is_merged(runs, r2));
+    cout << endl;
+  }
+  return 0;
+}
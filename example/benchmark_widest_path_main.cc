@@ -0,0 +1,199 @@
+/*
+  Solves the single-source widest path problem, i.e., finds for each vertex
+  the path maximizing the minimum edge weight on it, by a modified Dijkstra's
+  algorithm using |pair_radix_heap| with the |descending| policy and
+  |std::priority_queue|. Since the width of a path never increases as it is
+  extended, the keys extracted form a non-increasing sequence.
+  Reads graphs in the DIMACS format (http://www.dis.uniroma1.it/challenge9/format.shtml).
+  100 Sources are randomly selected and the average times are reported.
+
+  Usage: benchmark_widest_path_main GRAPH
+*/
+
+#include "radix_heap.h"
+#include <sys/time.h>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <queue>
+#include <iostream>
+using namespace std;
+
+typedef int vertex_t;
+typedef int weight_t;
+typedef pair<vertex_t, weight_t> edge_t;
+typedef vector<vector<edge_t>> graph_t;
+
+#define CHECK(expr)                                                     \
+  if (expr) {                                                           \
+  } else {                                                              \
+    fprintf(stderr, "CHECK Failed (%s:%d): %s\n",                       \
+            __FILE__, __LINE__, #expr);                                 \
+    exit(EXIT_FAILURE);                                                 \
+  }
+
+namespace {
+// xorshift64* random generator [Vigna, 2014]
+uint64_t x = 123456789LL;
+uint64_t xorshift64() {
+  x ^= x >> 12;  // a
+  x ^= x << 25;  // b
+  x ^= x >> 27;  // c
+  return x * 2685821657736338717LL;
+}
+
+inline double current_time_sec() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+void read_header(istream &ifs, vertex_t *num_vs, size_t *num_es) {
+  string line;
+  CHECK(getline(ifs, line));
+  istringstream ss(line);
+
+  string head;
+  CHECK(ss >> head);
+  if (head == "c") {
+    read_header(ifs, num_vs, num_es);
+    return;
+  }
+
+  CHECK(head == "p");
+  CHECK((ss >> head) && head == "sp");
+  CHECK(ss >> *num_vs >> *num_es);
+}
+
+bool read_edge(istream &ifs, vertex_t *s, vertex_t *t, weight_t *w) {
+  string line;
+  if (!getline(ifs, line) || line == "") return false;
+  istringstream ss(line);
+
+  string head;
+  CHECK(ss >> head);
+  if (head == "c") return read_edge(ifs, s, t, w);
+
+  CHECK(head == "a");
+  return (bool)(ss >> *s >> *t >> *w);
+}
+
+// Unreachable vertices have width 0.
+vector<weight_t> widest_path_stlpque(const graph_t &g, vertex_t s) {
+  vector<weight_t> width(g.size(), 0);
+  width[s] = numeric_limits<weight_t>::max();
+
+  typedef pair<weight_t, vertex_t> queue_entry_t;
+  priority_queue<queue_entry_t> que;
+  que.emplace(width[s], s);
+
+  while (!que.empty()) {
+    vertex_t v = que.top().second;
+    weight_t p = que.top().first;
+    que.pop();
+    if (p < width[v]) continue;
+
+    for (const auto &e : g[v]) {
+      vertex_t tv = e.first;
+      weight_t tp = min(p, e.second);
+      if (tp > width[tv]) {
+        width[tv] = tp;
+        que.emplace(tp, tv);
+      }
+    }
+  }
+
+  return width;
+}
+
+vector<weight_t> widest_path_rheap(const graph_t &g, vertex_t s) {
+  vector<weight_t> width(g.size(), 0);
+  width[s] = numeric_limits<weight_t>::max();
+
+  radix_heap::pair_radix_heap<weight_t, vertex_t, radix_heap::descending> que;
+  que.emplace(width[s], s);
+
+  while (!que.empty()) {
+    vertex_t v = que.top_value();
+    weight_t p = que.top_key();
+    que.pop();
+    if (p < width[v]) continue;
+
+    for (const auto &e : g[v]) {
+      vertex_t tv = e.first;
+      weight_t tp = min(p, e.second);
+      if (tp > width[tv]) {
+        width[tv] = tp;
+        que.emplace(tp, tv);
+      }
+    }
+  }
+
+  return width;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+  cout.imbue(std::locale(""));
+
+  CHECK(argc == 2);
+  cout << "#File\tV\tE\trheap(overall)\tstl(overall)" << endl;
+
+  // Load
+  graph_t g;
+  {
+    ifstream ifs(argv[1]);
+    CHECK(ifs);
+    ifs.sync_with_stdio(false);
+    {
+      string f(argv[1]);
+      size_t p = f.rfind('/');
+      if (p != string::npos) f = f.substr(p + 1);
+      cout << f;
+    }
+
+    vertex_t num_vs;
+    size_t num_es;
+    read_header(ifs, &num_vs, &num_es);
+    cout << "\t" << num_vs << "\t" << num_es;
+
+    g.resize(num_vs + 1);
+    for (size_t i = 0; i < num_es; ++i) {
+      vertex_t s, t;
+      weight_t w;
+      read_edge(ifs, &s, &t, &w);
+      g[s].emplace_back(t, w);
+    }
+  }
+
+  // Easy verification
+  {
+    constexpr int kNumVerificationSources = 10;
+    for (int i = 0; i < kNumVerificationSources; ++i) {
+      vertex_t s = xorshift64() % g.size();
+      CHECK(widest_path_stlpque(g, s) == widest_path_rheap(g, s));
+    }
+  }
+
+  // Benchmark
+  constexpr int kNumBenchmarkSources = 100;
+  vector<vertex_t> ss(kNumBenchmarkSources);
+  for (int i = 0; i < kNumBenchmarkSources; ++i) {
+    ss[i] = xorshift64() % g.size();
+  }
+
+  {
+    double t = current_time_sec();
+    for (vertex_t s : ss) widest_path_rheap(g, s);
+    cout << "\t" << (current_time_sec() - t) / ss.size();
+  }
+  {
+    double t = current_time_sec();
+    for (vertex_t s : ss) widest_path_stlpque(g, s);
+    cout << "\t" << (current_time_sec() - t) / ss.size();
+  }
+
+  cout << endl;
+  return 0;
+}
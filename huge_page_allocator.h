@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace radix_heap {
+namespace internal {
+constexpr size_t kHugePageSize = size_t(2) << 20;
+
+inline constexpr size_t round_up_to_huge_pages(size_t bytes) {
+  return (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+}
+
+#ifdef __linux__
+// Maps |bytes| (a multiple of |kHugePageSize|) of anonymous memory aligned to
+// huge pages. Explicit huge pages are tried first if |use_hugetlb|, and
+// otherwise transparent huge pages are requested by |madvise|.
+inline void *map_huge_pages(size_t bytes, bool use_hugetlb) {
+#ifdef MAP_HUGETLB
+  if (use_hugetlb) {
+    void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) return p;
+  }
+#else
+  (void)use_hugetlb;
+#endif
+
+  // Over-allocate by one huge page and trim so that the region is aligned.
+  const size_t mapped = bytes + kHugePageSize;
+  void *q = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (q == MAP_FAILED) return NULL;
+  char *b = static_cast<char*>(q);
+  char *a = reinterpret_cast<char*>
+      ((reinterpret_cast<uintptr_t>(b) + kHugePageSize - 1) & ~(kHugePageSize - 1));
+  if (a != b) munmap(b, a - b);
+  if (a + bytes != b + mapped) munmap(a + bytes, (b + mapped) - (a + bytes));
+#ifdef MADV_HUGEPAGE
+  madvise(a, bytes, MADV_HUGEPAGE);
+#endif
+  return a;
+}
+#endif
+}  // namespace internal
+
+// An allocator placing large blocks in 2 MB pages. Blocks of at least
+// |kMinHugeBytes| are rounded up to whole huge pages and mapped by |mmap|,
+// and smaller ones come from |malloc|. It is intended to be given to
+// |radix_heap| or |pair_radix_heap| as the allocator of bucket storage
+// in order to reduce TLB misses in |pull|. On non-Linux platforms,
+// every block comes from |malloc|.
+template<typename T, bool UseHugeTLB = false>
+class huge_page_allocator {
+ public:
+  typedef T value_type;
+  static constexpr size_t kMinHugeBytes = internal::kHugePageSize / 2;
+
+  template<typename U>
+  struct rebind {
+    typedef huge_page_allocator<U, UseHugeTLB> other;
+  };
+
+  huge_page_allocator() {}
+  template<typename U>
+  huge_page_allocator(const huge_page_allocator<U, UseHugeTLB> &) {}
+
+  T *allocate(size_t n) {
+    const size_t bytes = n * sizeof(T);
+    void *p;
+#ifdef __linux__
+    if (bytes >= kMinHugeBytes) {
+      p = internal::map_huge_pages(internal::round_up_to_huge_pages(bytes), UseHugeTLB);
+    } else {
+      p = std::malloc(bytes);
+    }
+#else
+    p = std::malloc(bytes);
+#endif
+    if (p == NULL) throw std::bad_alloc();
+    return static_cast<T*>(p);
+  }
+
+  void deallocate(T *p, size_t n) {
+#ifdef __linux__
+    const size_t bytes = n * sizeof(T);
+    if (bytes >= kMinHugeBytes) {
+      munmap(p, internal::round_up_to_huge_pages(bytes));
+      return;
+    }
+#else
+    (void)n;
+#endif
+    std::free(p);
+  }
+};
+
+template<typename T, typename U, bool UseHugeTLB>
+inline bool operator==(const huge_page_allocator<T, UseHugeTLB> &,
+                       const huge_page_allocator<U, UseHugeTLB> &) {
+  return true;
+}
+
+template<typename T, typename U, bool UseHugeTLB>
+inline bool operator!=(const huge_page_allocator<T, UseHugeTLB> &,
+                       const huge_page_allocator<U, UseHugeTLB> &) {
+  return false;
+}
+}  // namespace radix_heap
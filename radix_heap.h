@@ -1,9 +1,18 @@
+#pragma once
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <cfloat>
 #include <climits>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -33,6 +42,61 @@ inline constexpr size_t find_bucket(T x, T last) {
   return find_bucket_impl<sizeof(T) == 8>::find_bucket(x, last);
 }
 
+#ifdef __SIZEOF_INT128__
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+
+// Looks at the upper word only if it differs.
+inline constexpr size_t find_bucket(uint128_t x, uint128_t last) {
+  return uint64_t((x ^ last) >> 64) != 0
+      ? 128 - __builtin_clzll(uint64_t((x ^ last) >> 64))
+      : find_bucket_impl<true>::find_bucket(uint64_t(x), uint64_t(last));
+}
+#endif
+
+// Multi-word keys, compared lexicographically from the first word.
+template<size_t N>
+inline size_t find_bucket(const std::array<uint64_t, N> &x, const std::array<uint64_t, N> &last) {
+  for (size_t i = 0; i < N; ++i) {
+    if (x[i] != last[i]) return (N - i) * 64 - __builtin_clzll(x[i] ^ last[i]);
+  }
+  return 0;
+}
+
+// The number of bits and the maximum of unsigned key types. Unlike
+// |std::numeric_limits|, it also covers 128-bit integers in strict ISO mode
+// and multi-word keys.
+template<typename T>
+struct key_traits {
+  static constexpr int digits = std::numeric_limits<T>::digits;
+
+  static constexpr T max() {
+    return std::numeric_limits<T>::max();
+  }
+};
+
+#ifdef __SIZEOF_INT128__
+template<>
+struct key_traits<uint128_t> {
+  static constexpr int digits = 128;
+
+  static constexpr uint128_t max() {
+    return ~uint128_t(0);
+  }
+};
+#endif
+
+template<size_t N>
+struct key_traits<std::array<uint64_t, N>> {
+  static constexpr int digits = 64 * N;
+
+  static std::array<uint64_t, N> max() {
+    std::array<uint64_t, N> res;
+    res.fill(~uint64_t(0));
+    return res;
+  }
+};
+
 template<typename KeyType, bool IsSigned> class encoder_impl_integer;
 
 template<typename KeyType>
@@ -104,21 +168,536 @@ template<>
 class encoder<float> : public encoder_impl_decimal<float, uint32_t> {};
 template<>
 class encoder<double> : public encoder_impl_decimal<double, uint64_t> {};
+
+#ifdef __SIZEOF_INT128__
+// |std::is_signed| and |std::make_unsigned| do not know 128-bit integers in
+// strict ISO mode.
+template<>
+class encoder<uint128_t> {
+ public:
+  typedef uint128_t key_type;
+  typedef uint128_t unsigned_key_type;
+
+  inline static constexpr unsigned_key_type encode(key_type x) {
+    return x;
+  }
+
+  inline static constexpr key_type decode(unsigned_key_type x) {
+    return x;
+  }
+};
+
+template<>
+class encoder<int128_t> {
+ public:
+  typedef int128_t key_type;
+  typedef uint128_t unsigned_key_type;
+
+  inline static constexpr unsigned_key_type encode(key_type x) {
+    return static_cast<unsigned_key_type>(x) ^ (unsigned_key_type(1) << 127);
+  }
+
+  inline static constexpr key_type decode(unsigned_key_type x) {
+    return static_cast<key_type>(x ^ (unsigned_key_type(1) << 127));
+  }
+};
+
+#if LDBL_MANT_DIG == 64
+// x87 extended precision: a 64-bit significand with an explicit integer bit,
+// followed by a 15-bit exponent and the sign, in 80 bits.
+template<>
+class encoder<long double> {
+ public:
+  typedef long double key_type;
+  typedef uint128_t unsigned_key_type;
+
+  inline static unsigned_key_type encode(key_type x) {
+    uint64_t significand;
+    uint16_t sign_exponent;
+    memcpy(&significand, &x, 8);
+    memcpy(&sign_exponent, reinterpret_cast<const char*>(&x) + 8, 2);
+    const unsigned_key_type y = unsigned_key_type(sign_exponent) << 64 | significand;
+    return (sign_exponent >> 15) ? ~y & kMask : y | kSign;
+  }
+
+  inline static key_type decode(unsigned_key_type x) {
+    const unsigned_key_type y = (x & kSign) ? x & ~kSign : ~x & kMask;
+    const uint64_t significand = uint64_t(y);
+    const uint16_t sign_exponent = uint16_t(y >> 64);
+    key_type res = 0;
+    memcpy(&res, &significand, 8);
+    memcpy(reinterpret_cast<char*>(&res) + 8, &sign_exponent, 2);
+    return res;
+  }
+
+ private:
+  static constexpr unsigned_key_type kSign = unsigned_key_type(1) << 79;
+  static constexpr unsigned_key_type kMask = (unsigned_key_type(1) << 80) - 1;
+};
+#elif LDBL_MANT_DIG == 113
+template<>
+class encoder<long double> : public encoder_impl_decimal<long double, uint128_t> {};
+#endif
+#endif
+
+#if LDBL_MANT_DIG == 53
+template<>
+class encoder<long double> : public encoder_impl_decimal<long double, uint64_t> {};
+#endif
+
+#ifdef __FLT16_MAX__
+template<>
+class encoder<_Float16> : public encoder_impl_decimal<_Float16, uint16_t> {};
+#endif
+
+// Durations and time points are encoded by their counts.
+template<typename Rep, typename Period>
+class encoder<std::chrono::duration<Rep, Period>> {
+ public:
+  typedef std::chrono::duration<Rep, Period> key_type;
+  typedef typename encoder<Rep>::unsigned_key_type unsigned_key_type;
+
+  inline static constexpr unsigned_key_type encode(key_type x) {
+    return encoder<Rep>::encode(x.count());
+  }
+
+  inline static constexpr key_type decode(unsigned_key_type x) {
+    return key_type(encoder<Rep>::decode(x));
+  }
+};
+
+template<typename Clock, typename Duration>
+class encoder<std::chrono::time_point<Clock, Duration>> {
+ public:
+  typedef std::chrono::time_point<Clock, Duration> key_type;
+  typedef typename encoder<Duration>::unsigned_key_type unsigned_key_type;
+
+  inline static unsigned_key_type encode(key_type x) {
+    return encoder<Duration>::encode(x.time_since_epoch());
+  }
+
+  inline static key_type decode(unsigned_key_type x) {
+    return key_type(encoder<Duration>::decode(x));
+  }
+};
+
+// Multi-word keys are already unsigned and ordered lexicographically.
+template<size_t N>
+class encoder<std::array<uint64_t, N>> {
+ public:
+  typedef std::array<uint64_t, N> key_type;
+  typedef std::array<uint64_t, N> unsigned_key_type;
+
+  inline static const unsigned_key_type &encode(const key_type &x) {
+    return x;
+  }
+
+  inline static const key_type &decode(const unsigned_key_type &x) {
+    return x;
+  }
+};
 }  // namespace internal
 
-template<typename KeyType, typename EncoderType = internal::encoder<KeyType>>
-class radix_heap {
+// A tag given instead of an encoder to make a heap extract the maximum
+// first, e.g., |pair_radix_heap<uint32_t, V, descending>|. Pushed keys must
+// not be greater than the last extracted key.
+struct descending {};
+
+namespace internal {
+// Reverses the order of |BaseEncoder| by complementing encoded keys.
+template<typename KeyType, typename BaseEncoder = encoder<KeyType>>
+class descending_encoder {
+ public:
+  typedef KeyType key_type;
+  typedef typename BaseEncoder::unsigned_key_type unsigned_key_type;
+
+  inline static constexpr unsigned_key_type encode(key_type x) {
+    return unsigned_key_type(~BaseEncoder::encode(x));
+  }
+
+  inline static constexpr key_type decode(unsigned_key_type x) {
+    return BaseEncoder::decode(unsigned_key_type(~x));
+  }
+};
+
+// Resolves the encoder template argument of heaps, which is either an
+// encoder or a tag.
+template<typename KeyType, typename EncoderType>
+struct encoder_of {
+  typedef EncoderType type;
+};
+
+template<typename KeyType>
+struct encoder_of<KeyType, descending> {
+  typedef descending_encoder<KeyType> type;
+};
+}  // namespace internal
+
+// A field of |packed_key|: a value of integer type |T| stored in |Bits| bits.
+// Signed values are biased so that the order is preserved.
+template<typename T, int Bits>
+struct field {
+  static_assert(std::is_integral<T>::value, "fields must be integers");
+  static_assert(0 < Bits && Bits <= 64, "a field must have 1 to 64 bits");
+  typedef T value_type;
+  static constexpr int bits = Bits;
+};
+
+namespace internal {
+template<typename Field, bool IsSigned = std::is_signed<typename Field::value_type>::value>
+class field_codec;
+
+template<typename Field>
+class field_codec<Field, false> {
+ public:
+  typedef typename Field::value_type value_type;
+
+  inline static uint64_t encode(value_type v) {
+    assert(Field::bits >= 64 || uint64_t(v) >> Field::bits == 0);
+    return uint64_t(v);
+  }
+
+  inline static value_type decode(uint64_t u) {
+    return value_type(u);
+  }
+};
+
+template<typename Field>
+class field_codec<Field, true> {
+ public:
+  typedef typename Field::value_type value_type;
+
+  inline static uint64_t encode(value_type v) {
+    assert(Field::bits >= 64 || (-int64_t(kHalf) <= int64_t(v) && int64_t(v) < int64_t(kHalf)));
+    return (uint64_t(int64_t(v)) + kHalf) & kMask;
+  }
+
+  inline static value_type decode(uint64_t u) {
+    return Field::bits < 64 ? value_type(int64_t(u) - int64_t(kHalf)) : value_type(int64_t(u ^ kHalf));
+  }
+
+ private:
+  static constexpr uint64_t kHalf = uint64_t(1) << (Field::bits - 1);
+  static constexpr uint64_t kMask = kHalf | (kHalf - 1);
+};
+
+// Shifts without undefined behavior when |bits| is the width of |Word|.
+template<typename Word>
+inline Word shift_left(Word w, int bits) {
+  return bits >= key_traits<Word>::digits ? Word(0) : Word(w << bits);
+}
+
+template<typename Word, size_t I, typename... Fields>
+class field_packer;
+
+template<typename Word, size_t I>
+class field_packer<Word, I> {
+ public:
+  static constexpr int bits = 0;
+
+  template<typename Tuple>
+  inline static Word encode(const Tuple &, Word w) {
+    return w;
+  }
+
+  template<typename Tuple>
+  inline static void decode(Word, Tuple &) {}
+};
+
+// Packs the |I|-th and later fields, the earlier ones in higher bits.
+template<typename Word, size_t I, typename Field, typename... Rest>
+class field_packer<Word, I, Field, Rest...> {
+ public:
+  typedef field_packer<Word, I + 1, Rest...> next;
+  static constexpr int bits = Field::bits + next::bits;
+
+  template<typename Tuple>
+  inline static Word encode(const Tuple &t, Word w) {
+    return next::encode(t, shift_left(w, Field::bits) |
+                        Word(field_codec<Field>::encode(std::get<I>(t))));
+  }
+
+  template<typename Tuple>
+  inline static void decode(Word x, Tuple &t) {
+    const uint64_t mask = ~uint64_t(0) >> (64 - Field::bits);
+    std::get<I>(t) = field_codec<Field>::decode(uint64_t(x >> next::bits) & mask);
+    next::decode(x, t);
+  }
+};
+
+// The smallest unsigned word of at least |Bits| bits.
+template<int Bits>
+struct packed_word {
+#ifdef __SIZEOF_INT128__
+  static_assert(Bits <= 128, "packed keys must fit in 128 bits");
+  typedef typename std::conditional
+  <Bits <= 32, uint32_t, typename std::conditional
+   <Bits <= 64, uint64_t, uint128_t>::type>::type type;
+#else
+  static_assert(Bits <= 64, "packed keys must fit in 64 bits");
+  typedef typename std::conditional<Bits <= 32, uint32_t, uint64_t>::type type;
+#endif
+};
+}  // namespace internal
+
+// An encoder of |std::tuple|s of integers ordered lexicographically, e.g.,
+// (distance, hop count) keys broken ties by the second field. Each field is
+// stored in its declared number of bits, and the whole tuple is packed into
+// one unsigned word:
+//
+//   typedef packed_key<field<int32_t, 40>, field<uint16_t, 24>> encoder_type;
+//   pair_radix_heap<encoder_type::key_type, int, encoder_type> h;
+//   h.push(std::make_tuple(-5, 3), 42);
+//
+// Values out of the range of their fields are caught by assertions.
+template<typename... Fields>
+class packed_key {
+ public:
+  typedef std::tuple<typename Fields::value_type...> key_type;
+  typedef typename internal::packed_word
+  <internal::field_packer<uint64_t, 0, Fields...>::bits>::type unsigned_key_type;
+
+  inline static unsigned_key_type encode(const key_type &key) {
+    return packer::encode(key, unsigned_key_type());
+  }
+
+  inline static key_type decode(unsigned_key_type x) {
+    key_type key;
+    packer::decode(x, key);
+    return key;
+  }
+
+ private:
+  typedef internal::field_packer<unsigned_key_type, 0, Fields...> packer;
+};
+
+// A 16-bit brain floating-point number: the upper half of a |float|.
+// Conversion from |float| rounds to the nearest even.
+class bfloat16 {
+ public:
+  bfloat16() : bits_(0) {}
+
+  explicit bfloat16(float f) : bits_(round(f)) {}
+
+  explicit operator float() const {
+    const uint32_t u = uint32_t(bits_) << 16;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+  }
+
+  static bfloat16 from_bits(uint16_t bits) {
+    bfloat16 res;
+    res.bits_ = bits;
+    return res;
+  }
+
+  uint16_t bits() const {
+    return bits_;
+  }
+
+  friend bool operator==(bfloat16 a, bfloat16 b) {
+    return float(a) == float(b);
+  }
+
+  friend bool operator!=(bfloat16 a, bfloat16 b) {
+    return !(a == b);
+  }
+
+  friend bool operator<(bfloat16 a, bfloat16 b) {
+    return float(a) < float(b);
+  }
+
+ private:
+  uint16_t bits_;
+
+  static uint16_t round(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    // Keeps NaNs quiet instead of letting rounding turn them into infinities.
+    if ((u & 0x7FFFFFFFu) > 0x7F800000u) return uint16_t((u >> 16) | 0x40);
+    return uint16_t((u + 0x7FFFu + ((u >> 16) & 1)) >> 16);
+  }
+};
+
+// A signed or unsigned fixed-point number of integer type |Int| with
+// |Frac| fractional bits, e.g., |fixed_point<int64_t, 32>| for Q32.32.
+template<typename Int, int Frac>
+class fixed_point {
+ public:
+  static_assert(std::is_integral<Int>::value, "fixed_point needs an integer type");
+  static_assert(0 <= Frac && Frac < std::numeric_limits<Int>::digits, "too many fractional bits");
+  typedef Int raw_type;
+  static constexpr int fraction_bits = Frac;
+
+  constexpr fixed_point() : raw_() {}
+
+  explicit constexpr fixed_point(double x) : raw_(Int(x * double(uint64_t(1) << Frac))) {}
+
+  static constexpr fixed_point from_raw(Int raw) {
+    return fixed_point(raw, 0);
+  }
+
+  constexpr Int raw() const {
+    return raw_;
+  }
+
+  explicit constexpr operator double() const {
+    return double(raw_) / double(uint64_t(1) << Frac);
+  }
+
+  friend constexpr fixed_point operator+(fixed_point a, fixed_point b) {
+    return from_raw(a.raw_ + b.raw_);
+  }
+
+  friend constexpr fixed_point operator-(fixed_point a, fixed_point b) {
+    return from_raw(a.raw_ - b.raw_);
+  }
+
+  friend constexpr bool operator==(fixed_point a, fixed_point b) {
+    return a.raw_ == b.raw_;
+  }
+
+  friend constexpr bool operator!=(fixed_point a, fixed_point b) {
+    return a.raw_ != b.raw_;
+  }
+
+  friend constexpr bool operator<(fixed_point a, fixed_point b) {
+    return a.raw_ < b.raw_;
+  }
+
+ private:
+  Int raw_;
+
+  constexpr fixed_point(Int raw, int) : raw_(raw) {}
+};
+
+namespace internal {
+// The sign-flip of |encoder_impl_decimal| on the bits of |bfloat16|.
+template<>
+class encoder<bfloat16> {
+ public:
+  typedef bfloat16 key_type;
+  typedef uint16_t unsigned_key_type;
+
+  inline static unsigned_key_type encode(key_type x) {
+    const uint16_t u = x.bits();
+    return u ^ ((u >> 15) ? 0xFFFFu : 0x8000u);
+  }
+
+  inline static key_type decode(unsigned_key_type x) {
+    return bfloat16::from_bits(x ^ ((x >> 15) ? 0x8000u : 0xFFFFu));
+  }
+};
+
+template<typename Int, int Frac>
+class encoder<fixed_point<Int, Frac>> {
+ public:
+  typedef fixed_point<Int, Frac> key_type;
+  typedef typename encoder<Int>::unsigned_key_type unsigned_key_type;
+
+  inline static constexpr unsigned_key_type encode(key_type x) {
+    return encoder<Int>::encode(x.raw());
+  }
+
+  inline static constexpr key_type decode(unsigned_key_type x) {
+    return key_type::from_raw(encoder<Int>::decode(x));
+  }
+};
+}  // namespace internal
+
+// An encoder of keys in a known range, e.g., travel times in [0, 86400) as
+// doubles, rounding them to the nearest multiple of |precision| above
+// |offset|. Nearby keys then share high bits and are redistributed less
+// often than by their raw bits. Keys out of the range are caught by
+// assertions in debug builds.
+//
+// Unlike other encoders, it has a state. Give it to the constructor of
+// |radix_heap| or |pair_radix_heap|.
+template<typename KeyType = double, typename UnsignedKeyType = uint32_t>
+class quantized_encoder {
+ public:
+  typedef KeyType key_type;
+  typedef UnsignedKeyType unsigned_key_type;
+
+  quantized_encoder() : offset_(0), precision_(1), scale_(1) {}
+
+  quantized_encoder(key_type offset, key_type precision)
+      : offset_(offset), precision_(precision), scale_(1 / precision) {}
+
+  unsigned_key_type encode(key_type x) const {
+    const key_type y = (x - offset_) * scale_ + key_type(0.5);
+    assert(0 <= y && y < key_type(internal::key_traits<unsigned_key_type>::max()) + 1);
+    return unsigned_key_type(y);
+  }
+
+  key_type decode(unsigned_key_type x) const {
+    return offset_ + x * precision_;
+  }
+
+ private:
+  key_type offset_, precision_, scale_;
+};
+
+namespace internal {
+// The encoder of a heap, taking no space if it has no state.
+template<typename EncoderType, bool = std::is_empty<EncoderType>::value>
+class encoder_holder {
+ public:
+  encoder_holder() : encoder_() {}
+  explicit encoder_holder(const EncoderType &encoder) : encoder_(encoder) {}
+
+  const EncoderType &encoder() const {
+    return encoder_;
+  }
+
+ protected:
+  void swap_encoder(encoder_holder &a) {
+    std::swap(encoder_, a.encoder_);
+  }
+
+ private:
+  EncoderType encoder_;
+};
+
+template<typename EncoderType>
+class encoder_holder<EncoderType, true> : private EncoderType {
+ public:
+  encoder_holder() {}
+  explicit encoder_holder(const EncoderType &encoder) : EncoderType(encoder) {}
+
+  const EncoderType &encoder() const {
+    return *this;
+  }
+
+ protected:
+  void swap_encoder(encoder_holder &) {}
+};
+}  // namespace internal
+
+namespace internal {
+// The standard implementation of |radix_heap|.
+template<typename KeyType, typename EncoderType, typename Allocator>
+class bucket_radix_heap
+    : public internal::encoder_holder<typename internal::encoder_of<KeyType, EncoderType>::type> {
  public:
   typedef KeyType key_type;
-  typedef EncoderType encoder_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
   typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+  typedef typename std::allocator_traits<Allocator>::template
+  rebind_alloc<unsigned_key_type> allocator_type;
+
+  bucket_radix_heap() : size_(0), last_(), buckets_() {
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
+  }
 
-  radix_heap() : size_(0), last_(), buckets_() {
-    buckets_min_.fill(std::numeric_limits<unsigned_key_type>::max());
+  explicit bucket_radix_heap(const encoder_type &encoder)
+      : internal::encoder_holder<encoder_type>(encoder), size_(0), last_(), buckets_() {
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
   }
 
   void push(key_type key) {
-    const unsigned_key_type x = encoder_type::encode(key);
+    const unsigned_key_type x = this->encoder().encode(key);
     assert(last_ <= x);
     ++size_;
     const size_t k = internal::find_bucket(x, last_);
@@ -128,7 +707,7 @@ class radix_heap {
 
   key_type top() {
     pull();
-    return encoder_type::decode(last_);
+    return this->encoder().decode(last_);
   }
 
   void pop() {
@@ -147,12 +726,13 @@ class radix_heap {
 
   void clear() {
     size_ = 0;
-    last_ = key_type();
+    last_ = unsigned_key_type();
     for (auto &b : buckets_) b.clear();
-    buckets_min_.fill(std::numeric_limits<unsigned_key_type>::max());
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
   }
 
-  void swap(radix_heap<KeyType, EncoderType> &a) {
+  void swap(bucket_radix_heap<KeyType, EncoderType, Allocator> &a) {
+    this->swap_encoder(a);
     std::swap(size_, a.size_);
     std::swap(last_, a.last_);
     buckets_.swap(a.buckets_);
@@ -162,10 +742,10 @@ class radix_heap {
  private:
   size_t size_;
   unsigned_key_type last_;
-  std::array<std::vector<unsigned_key_type>,
-             std::numeric_limits<unsigned_key_type>::digits + 1> buckets_;
+  std::array<std::vector<unsigned_key_type, allocator_type>,
+             internal::key_traits<unsigned_key_type>::digits + 1> buckets_;
   std::array<unsigned_key_type,
-             std::numeric_limits<unsigned_key_type>::digits + 1> buckets_min_;
+             internal::key_traits<unsigned_key_type>::digits + 1> buckets_min_;
 
   void pull() {
     assert(size_ > 0);
@@ -181,24 +761,339 @@ class radix_heap {
       buckets_min_[k] = std::min(buckets_min_[k], x);
     }
     buckets_[i].clear();
-    buckets_min_[i] = std::numeric_limits<unsigned_key_type>::max();
+    buckets_min_[i] = internal::key_traits<unsigned_key_type>::max();
   }
 };
 
-template<typename KeyType, typename ValueType, typename EncoderType = internal::encoder<KeyType>>
-class pair_radix_heap {
+// The implementation of |radix_heap| for keys of at most 16 bits. It keeps
+// the count of every possible key and a three-level bitmap of nonzero counts,
+// so that both |push| and |pop| take constant time.
+template<typename KeyType, typename EncoderType, typename Allocator>
+class direct_address_heap
+    : public internal::encoder_holder<typename internal::encoder_of<KeyType, EncoderType>::type> {
  public:
   typedef KeyType key_type;
-  typedef ValueType value_type;
-  typedef EncoderType encoder_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
   typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+  typedef typename std::allocator_traits<Allocator>::template
+  rebind_alloc<unsigned_key_type> allocator_type;
 
-  pair_radix_heap() : size_(0), last_(), buckets_() {
-    buckets_min_.fill(std::numeric_limits<unsigned_key_type>::max());
-  }
+  direct_address_heap() : size_(0), last_(), top_mask_(0), middle_masks_() {}
 
-  void push(key_type key, const value_type &value) {
-    const unsigned_key_type x = encoder_type::encode(key);
+  explicit direct_address_heap(const encoder_type &encoder)
+      : internal::encoder_holder<encoder_type>(encoder),
+        size_(0), last_(), top_mask_(0), middle_masks_() {}
+
+  void push(key_type key) {
+    const unsigned_key_type x = this->encoder().encode(key);
+    assert(last_ <= x);
+    if (counts_.empty()) {
+      counts_.resize(kNumKeys);
+      masks_.resize(kNumMasks);
+    }
+    ++size_;
+    if (counts_[x]++ == 0) {
+      masks_[x / 64] |= uint64_t(1) << (x % 64);
+      middle_masks_[x / 64 / 64] |= uint64_t(1) << (x / 64 % 64);
+      top_mask_ |= uint64_t(1) << (x / 64 / 64);
+    }
+  }
+
+  key_type top() {
+    pull();
+    return this->encoder().decode(last_);
+  }
+
+  void pop() {
+    pull();
+    if (--counts_[last_] == 0) unset(last_);
+    --size_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    while (top_mask_ != 0) {
+      const size_t i = __builtin_ctzll(top_mask_);
+      while (middle_masks_[i] != 0) {
+        const size_t j = i * 64 + __builtin_ctzll(middle_masks_[i]);
+        while (masks_[j] != 0) {
+          const size_t x = j * 64 + __builtin_ctzll(masks_[j]);
+          counts_[x] = 0;
+          masks_[j] &= masks_[j] - 1;
+        }
+        middle_masks_[i] &= middle_masks_[i] - 1;
+      }
+      top_mask_ &= top_mask_ - 1;
+    }
+    size_ = 0;
+    last_ = unsigned_key_type();
+  }
+
+  void swap(direct_address_heap<KeyType, EncoderType, Allocator> &a) {
+    this->swap_encoder(a);
+    std::swap(size_, a.size_);
+    std::swap(last_, a.last_);
+    std::swap(top_mask_, a.top_mask_);
+    middle_masks_.swap(a.middle_masks_);
+    masks_.swap(a.masks_);
+    counts_.swap(a.counts_);
+  }
+
+ private:
+  static constexpr size_t kNumKeys = size_t(1) << internal::key_traits<unsigned_key_type>::digits;
+  static constexpr size_t kNumMasks = (kNumKeys + 63) / 64;
+  static constexpr size_t kNumMiddleMasks = (kNumMasks + 63) / 64;
+  static_assert(kNumMiddleMasks <= 64, "too many keys for direct addressing");
+
+  size_t size_;
+  unsigned_key_type last_;
+  uint64_t top_mask_;
+  std::array<uint64_t, kNumMiddleMasks> middle_masks_;
+  // Allocated on the first push.
+  std::vector<uint64_t, typename std::allocator_traits<Allocator>::template
+              rebind_alloc<uint64_t>> masks_;
+  std::vector<size_t, typename std::allocator_traits<Allocator>::template
+              rebind_alloc<size_t>> counts_;
+
+  void unset(size_t x) {
+    if ((masks_[x / 64] &= ~(uint64_t(1) << (x % 64))) != 0) return;
+    if ((middle_masks_[x / 64 / 64] &= ~(uint64_t(1) << (x / 64 % 64))) != 0) return;
+    top_mask_ &= ~(uint64_t(1) << (x / 64 / 64));
+  }
+
+  void pull() {
+    assert(size_ > 0);
+    if (counts_[last_] != 0) return;
+
+    const size_t i = __builtin_ctzll(top_mask_);
+    const size_t j = i * 64 + __builtin_ctzll(middle_masks_[i]);
+    last_ = j * 64 + __builtin_ctzll(masks_[j]);
+  }
+};
+}  // namespace internal
+
+namespace internal {
+template<typename KeyType, typename EncoderType, typename Allocator>
+struct radix_heap_base {
+  typedef typename std::conditional
+  <key_traits<typename encoder_of<KeyType, EncoderType>::type::unsigned_key_type>::digits <= 16,
+   direct_address_heap<KeyType, EncoderType, Allocator>,
+   bucket_radix_heap<KeyType, EncoderType, Allocator>>::type type;
+};
+}  // namespace internal
+
+// A monotone priority queue of keys. Keys of at most 16 bits (after
+// encoding) are handled by direct addressing instead of radix buckets.
+template<typename KeyType, typename EncoderType = internal::encoder<KeyType>,
+         typename Allocator = std::allocator<KeyType>>
+class radix_heap : public internal::radix_heap_base<KeyType, EncoderType, Allocator>::type {
+ public:
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+
+  radix_heap() {}
+  explicit radix_heap(const encoder_type &encoder)
+      : internal::radix_heap_base<KeyType, EncoderType, Allocator>::type(encoder) {}
+};
+
+// A multiset variant of |radix_heap|. Duplicate keys are run-length encoded
+// as (key, count) entries, so redistribution cost depends on the number of
+// runs rather than on the number of keys. Each bucket keeps the copies of its
+// minimum key in one run, and a key equal to that of the last run is merged
+// into it; other copies of a key may be split into several runs.
+template<typename KeyType, typename EncoderType = internal::encoder<KeyType>>
+class counting_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+
+  counting_radix_heap() : size_(0), last_(), buckets_(), buckets_min_index_() {
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
+  }
+
+  void push(key_type key, size_t count = 1) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    assert(last_ <= x);
+    if (count == 0) return;
+    size_ += count;
+    const size_t k = internal::find_bucket(x, last_);
+    append(k, x, count);
+  }
+
+  key_type top() {
+    pull();
+    return encoder_type::decode(last_);
+  }
+
+  // The number of copies of the minimum key.
+  size_t top_count() {
+    pull();
+    return buckets_[0].back().second;
+  }
+
+  void pop() {
+    pull();
+    if (--buckets_[0].back().second == 0) buckets_[0].pop_back();
+    --size_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    size_ = 0;
+    last_ = unsigned_key_type();
+    for (auto &b : buckets_) b.clear();
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
+  }
+
+  void swap(counting_radix_heap<KeyType, EncoderType> &a) {
+    std::swap(size_, a.size_);
+    std::swap(last_, a.last_);
+    buckets_.swap(a.buckets_);
+    buckets_min_.swap(a.buckets_min_);
+    buckets_min_index_.swap(a.buckets_min_index_);
+  }
+
+ private:
+  size_t size_;
+  unsigned_key_type last_;
+  std::array<std::vector<std::pair<unsigned_key_type, size_t>>,
+             internal::key_traits<unsigned_key_type>::digits + 1> buckets_;
+  std::array<unsigned_key_type,
+             internal::key_traits<unsigned_key_type>::digits + 1> buckets_min_;
+  // The index of the run of |buckets_min_| in each bucket.
+  std::array<size_t, internal::key_traits<unsigned_key_type>::digits + 1> buckets_min_index_;
+
+  // Bucket 0 only holds keys equal to |last_|, so it never has more than one run.
+  void append(size_t k, unsigned_key_type x, size_t count) {
+    auto &b = buckets_[k];
+    if (b.empty() || x < buckets_min_[k]) {
+      buckets_min_[k] = x;
+      buckets_min_index_[k] = b.size();
+      b.emplace_back(x, count);
+    } else if (x == buckets_min_[k]) {
+      b[buckets_min_index_[k]].second += count;
+    } else if (b.back().first == x) {
+      b.back().second += count;
+    } else {
+      b.emplace_back(x, count);
+    }
+  }
+
+  void pull() {
+    assert(size_ > 0);
+    if (!buckets_[0].empty()) return;
+
+    size_t i;
+    for (i = 1; buckets_[i].empty(); ++i);
+    last_ = buckets_min_[i];
+
+    for (const auto &r : buckets_[i]) {
+      append(internal::find_bucket(r.first, last_), r.first, r.second);
+    }
+    buckets_[i].clear();
+    buckets_min_[i] = internal::key_traits<unsigned_key_type>::max();
+  }
+};
+
+namespace internal {
+// Moves the elements of bucket |i| of |pair_radix_heap| to the lower buckets
+// one by one, once |last| has become the minimum key in the bucket.
+class sequential_redistributor {
+ public:
+  template<typename Buckets, typename BucketsMin, typename UnsignedKeyType>
+  void redistribute(Buckets &buckets, BucketsMin &buckets_min, size_t i, UnsignedKeyType last) {
+    for (size_t j = 0; j < buckets[i].size(); ++j) {
+      const UnsignedKeyType x = buckets[i][j].first;
+      const size_t k = find_bucket(x, last);
+      buckets[k].emplace_back(std::move(buckets[i][j]));
+      buckets_min[k] = std::min(buckets_min[k], x);
+    }
+  }
+};
+
+// The redistributor of |pair_radix_heap|, taking no space if it has no state.
+template<typename Redistributor, bool = std::is_empty<Redistributor>::value>
+class redistributor_holder {
+ public:
+  redistributor_holder() : redistributor_() {}
+  explicit redistributor_holder(const Redistributor &redistributor)
+      : redistributor_(redistributor) {}
+
+ protected:
+  Redistributor &redistributor() {
+    return redistributor_;
+  }
+
+  void swap_redistributor(redistributor_holder &a) {
+    using std::swap;
+    swap(redistributor_, a.redistributor_);
+  }
+
+ private:
+  Redistributor redistributor_;
+};
+
+template<typename Redistributor>
+class redistributor_holder<Redistributor, true> : private Redistributor {
+ public:
+  redistributor_holder() {}
+  explicit redistributor_holder(const Redistributor &redistributor)
+      : Redistributor(redistributor) {}
+
+ protected:
+  Redistributor &redistributor() {
+    return *this;
+  }
+
+  void swap_redistributor(redistributor_holder &) {}
+};
+}  // namespace internal
+
+// |Redistributor| moves the elements of a pulled bucket to the lower
+// buckets, as |internal::sequential_redistributor| does.
+template<typename KeyType, typename ValueType, typename EncoderType = internal::encoder<KeyType>,
+         typename Allocator = std::allocator<std::pair<KeyType, ValueType>>,
+         typename Redistributor = internal::sequential_redistributor>
+class pair_radix_heap
+    : public internal::encoder_holder<typename internal::encoder_of<KeyType, EncoderType>::type>,
+      private internal::redistributor_holder<Redistributor> {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+  typedef typename std::allocator_traits<Allocator>::template
+  rebind_alloc<std::pair<unsigned_key_type, value_type>> allocator_type;
+  typedef Redistributor redistributor_type;
+
+  pair_radix_heap() : size_(0), last_(), buckets_() {
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
+  }
+
+  explicit pair_radix_heap(const encoder_type &encoder,
+                           const redistributor_type &redistributor = redistributor_type())
+      : internal::encoder_holder<encoder_type>(encoder),
+        internal::redistributor_holder<Redistributor>(redistributor),
+        size_(0), last_(), buckets_() {
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
+  }
+
+  void push(key_type key, const value_type &value) {
+    const unsigned_key_type x = this->encoder().encode(key);
     assert(last_ <= x);
     ++size_;
     const size_t k = internal::find_bucket(x, last_);
@@ -207,7 +1102,7 @@ class pair_radix_heap {
   }
 
   void push(key_type key, value_type &&value) {
-    const unsigned_key_type x = encoder_type::encode(key);
+    const unsigned_key_type x = this->encoder().encode(key);
     assert(last_ <= x);
     ++size_;
     const size_t k = internal::find_bucket(x, last_);
@@ -217,18 +1112,19 @@ class pair_radix_heap {
 
   template <class... Args>
   void emplace(key_type key, Args&&... args) {
-    const unsigned_key_type x = encoder_type::encode(key);
+    const unsigned_key_type x = this->encoder().encode(key);
     assert(last_ <= x);
     ++size_;
     const size_t k = internal::find_bucket(x, last_);
     buckets_[k].emplace_back(std::piecewise_construct,
-                             std::forward_as_tuple(x), std::forward_as_tuple(args...));
+                             std::forward_as_tuple(x),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
     buckets_min_[k] = std::min(buckets_min_[k], x);
   }
 
   key_type top_key() {
     pull();
-    return encoder_type::decode(last_);
+    return this->encoder().decode(last_);
   }
 
   value_type &top_value() {
@@ -242,6 +1138,128 @@ class pair_radix_heap {
     --size_;
   }
 
+  // Pops all the elements with the minimum key at once, appending their
+  // values to |values|, and returns the key. The values are in no particular
+  // order.
+  key_type pop_top_group(std::vector<value_type> &values) {
+    pull();
+    for (auto &e : buckets_[0]) values.push_back(std::move(e.second));
+    size_ -= buckets_[0].size();
+    buckets_[0].clear();
+    return this->encoder().decode(last_);
+  }
+
+  // Pushes key-value pairs in |[first, last)|.
+  template<typename InputIterator>
+  void push_range(InputIterator first, InputIterator last) {
+    for (; first != last; ++first) push(first->first, first->second);
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    size_ = 0;
+    last_ = unsigned_key_type();
+    for (auto &b : buckets_) b.clear();
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
+  }
+
+  void swap(pair_radix_heap<KeyType, ValueType, EncoderType, Allocator, Redistributor> &a) {
+    this->swap_encoder(a);
+    this->swap_redistributor(a);
+    std::swap(size_, a.size_);
+    std::swap(last_, a.last_);
+    buckets_.swap(a.buckets_);
+    buckets_min_.swap(a.buckets_min_);
+  }
+
+ private:
+  size_t size_;
+  unsigned_key_type last_;
+  std::array<std::vector<std::pair<unsigned_key_type, value_type>, allocator_type>,
+             internal::key_traits<unsigned_key_type>::digits + 1> buckets_;
+  std::array<unsigned_key_type,
+             internal::key_traits<unsigned_key_type>::digits + 1> buckets_min_;
+
+  void pull() {
+    assert(size_ > 0);
+    if (!buckets_[0].empty()) return;
+
+    size_t i;
+    for (i = 1; buckets_[i].empty(); ++i);
+    last_ = buckets_min_[i];
+
+    this->redistributor().redistribute(buckets_, buckets_min_, i, last_);
+    buckets_[i].clear();
+    buckets_min_[i] = internal::key_traits<unsigned_key_type>::max();
+  }
+};
+
+// A monotone priority queue of values which embed their own keys, e.g.,
+// labels holding their distances. Buckets hold only values, and keys are
+// extracted by |KeyOf|, a function object taking a value, whenever values
+// are placed. The key of a value must not change while it is in the heap.
+template<typename ValueType, typename KeyOf,
+         typename EncoderType = internal::encoder<typename std::decay<
+           decltype(std::declval<KeyOf>()(std::declval<const ValueType&>()))>::type>,
+         typename Allocator = std::allocator<ValueType>>
+class radix_heap_by
+    : public internal::encoder_holder<typename internal::encoder_of<typename std::decay<
+        decltype(std::declval<KeyOf>()(std::declval<const ValueType&>()))>::type,
+        EncoderType>::type> {
+ public:
+  typedef ValueType value_type;
+  typedef KeyOf key_of_type;
+  typedef typename std::decay<
+    decltype(std::declval<KeyOf>()(std::declval<const ValueType&>()))>::type key_type;
+  typedef typename internal::encoder_of<key_type, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+  typedef typename std::allocator_traits<Allocator>::template
+  rebind_alloc<value_type> allocator_type;
+
+  explicit radix_heap_by(const key_of_type &key_of = key_of_type(),
+                         const encoder_type &encoder = encoder_type())
+      : internal::encoder_holder<encoder_type>(encoder),
+        key_of_(key_of), size_(0), last_(), buckets_() {
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
+  }
+
+  void push(const value_type &value) {
+    append(encode(value), value);
+  }
+
+  void push(value_type &&value) {
+    const unsigned_key_type x = encode(value);
+    append(x, std::move(value));
+  }
+
+  template <class... Args>
+  void emplace(Args&&... args) {
+    push(value_type(std::forward<Args>(args)...));
+  }
+
+  key_type top_key() {
+    pull();
+    return this->encoder().decode(last_);
+  }
+
+  value_type &top() {
+    pull();
+    return buckets_[0].back();
+  }
+
+  void pop() {
+    pull();
+    buckets_[0].pop_back();
+    --size_;
+  }
+
   size_t size() const {
     return size_;
   }
@@ -252,12 +1270,14 @@ class pair_radix_heap {
 
   void clear() {
     size_ = 0;
-    last_ = key_type();
+    last_ = unsigned_key_type();
     for (auto &b : buckets_) b.clear();
-    buckets_min_.fill(std::numeric_limits<unsigned_key_type>::max());
+    buckets_min_.fill(internal::key_traits<unsigned_key_type>::max());
   }
 
-  void swap(pair_radix_heap<KeyType, ValueType, EncoderType> &a) {
+  void swap(radix_heap_by<ValueType, KeyOf, EncoderType, Allocator> &a) {
+    this->swap_encoder(a);
+    std::swap(key_of_, a.key_of_);
     std::swap(size_, a.size_);
     std::swap(last_, a.last_);
     buckets_.swap(a.buckets_);
@@ -265,12 +1285,26 @@ class pair_radix_heap {
   }
 
  private:
+  key_of_type key_of_;
   size_t size_;
   unsigned_key_type last_;
-  std::array<std::vector<std::pair<unsigned_key_type, value_type>>,
-             std::numeric_limits<unsigned_key_type>::digits + 1> buckets_;
+  std::array<std::vector<value_type, allocator_type>,
+             internal::key_traits<unsigned_key_type>::digits + 1> buckets_;
   std::array<unsigned_key_type,
-             std::numeric_limits<unsigned_key_type>::digits + 1> buckets_min_;
+             internal::key_traits<unsigned_key_type>::digits + 1> buckets_min_;
+
+  unsigned_key_type encode(const value_type &value) const {
+    return this->encoder().encode(key_of_(value));
+  }
+
+  template<typename T>
+  void append(unsigned_key_type x, T &&value) {
+    assert(last_ <= x);
+    ++size_;
+    const size_t k = internal::find_bucket(x, last_);
+    buckets_[k].push_back(std::forward<T>(value));
+    buckets_min_[k] = std::min(buckets_min_[k], x);
+  }
 
   void pull() {
     assert(size_ > 0);
@@ -280,14 +1314,910 @@ class pair_radix_heap {
     for (i = 1; buckets_[i].empty(); ++i);
     last_ = buckets_min_[i];
 
-    for (size_t j = 0; j < buckets_[i].size(); ++j) {
-      const unsigned_key_type x = buckets_[i][j].first;
+    for (auto &v : buckets_[i]) {
+      const unsigned_key_type x = encode(v);
       const size_t k = internal::find_bucket(x, last_);
-      buckets_[k].emplace_back(std::move(buckets_[i][j]));
+      buckets_[k].push_back(std::move(v));
       buckets_min_[k] = std::min(buckets_min_[k], x);
     }
     buckets_[i].clear();
-    buckets_min_[i] = std::numeric_limits<unsigned_key_type>::max();
+    buckets_min_[i] = internal::key_traits<unsigned_key_type>::max();
+  }
+};
+
+namespace internal {
+// A vector-like bucket packed into (pointer, 32-bit size, 32-bit capacity).
+template<typename T>
+class compact_bucket {
+ public:
+  compact_bucket() : data_(NULL), size_(0), capacity_(0) {}
+
+  compact_bucket(const compact_bucket &b) : data_(NULL), size_(0), capacity_(0) {
+    reserve(b.size_);
+    for (uint32_t i = 0; i < b.size_; ++i) new (data_ + i) T(b.data_[i]);
+    size_ = b.size_;
+  }
+
+  ~compact_bucket() {
+    clear();
+    ::operator delete(data_);
+  }
+
+  compact_bucket &operator=(const compact_bucket &b) {
+    compact_bucket(b).swap(*this);
+    return *this;
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  T &operator[](size_t i) { return data_[i]; }
+  T &back() { return data_[size_ - 1]; }
+
+  template<class... Args>
+  void emplace_back(Args&&... args) {
+    if (size_ == capacity_) grow();
+    new (data_ + size_) T(std::forward<Args>(args)...);
+    ++size_;
+  }
+
+  void pop_back() {
+    data_[--size_].~T();
+  }
+
+  void clear() {
+    for (uint32_t i = 0; i < size_; ++i) data_[i].~T();
+    size_ = 0;
+  }
+
+  void swap(compact_bucket &b) {
+    std::swap(data_, b.data_);
+    std::swap(size_, b.size_);
+    std::swap(capacity_, b.capacity_);
   }
+
+ private:
+  T *data_;
+  uint32_t size_, capacity_;
+
+  // Doubles the capacity, up to 2^32 - 1 elements.
+  void grow() {
+    const size_t max_capacity = std::numeric_limits<uint32_t>::max();
+    if (capacity_ == max_capacity) throw std::length_error("compact_bucket: too many elements");
+    reserve(capacity_ == 0 ? 4 : std::min(size_t(capacity_) * 2, max_capacity));
+  }
+
+  void reserve(size_t n) {
+    if (n <= capacity_) return;
+    T *data = static_cast<T*>(::operator new(n * sizeof(T)));
+    for (uint32_t i = 0; i < size_; ++i) {
+      new (data + i) T(std::move(data_[i]));
+      data_[i].~T();
+    }
+    ::operator delete(data_);
+    data_ = data;
+    capacity_ = static_cast<uint32_t>(n);
+  }
+};
+
+// The whole state of a compact heap, allocated on the first push.
+template<typename ElementType, typename UnsignedKeyType>
+struct compact_bucket_block {
+  size_t size;
+  UnsignedKeyType last;
+  std::array<compact_bucket<ElementType>,
+             internal::key_traits<UnsignedKeyType>::digits + 1> buckets;
+  std::array<UnsignedKeyType,
+             internal::key_traits<UnsignedKeyType>::digits + 1> buckets_min;
+
+  compact_bucket_block() : size(0), last(), buckets() {
+    buckets_min.fill(internal::key_traits<UnsignedKeyType>::max());
+  }
+};
+}  // namespace internal
+
+// |radix_heap| with a pointer-sized header. Buckets are allocated on the
+// first push and released by |clear|, so that idle heaps are cheap to keep,
+// construct and swap. Each bucket holds at most 2^32 - 1 keys; pushing more
+// throws |std::length_error|.
+template<typename KeyType, typename EncoderType = internal::encoder<KeyType>>
+class compact_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+
+  compact_radix_heap() {}
+
+  compact_radix_heap(const compact_radix_heap &h)
+      : block_(h.block_ ? new block_type(*h.block_) : NULL) {}
+
+  compact_radix_heap(compact_radix_heap &&h) = default;
+
+  compact_radix_heap &operator=(compact_radix_heap h) {
+    swap(h);
+    return *this;
+  }
+
+  void push(key_type key) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    if (!block_) block_.reset(new block_type());
+    assert(block_->last <= x);
+    ++block_->size;
+    const size_t k = internal::find_bucket(x, block_->last);
+    block_->buckets[k].emplace_back(x);
+    block_->buckets_min[k] = std::min(block_->buckets_min[k], x);
+  }
+
+  key_type top() {
+    pull();
+    return encoder_type::decode(block_->last);
+  }
+
+  void pop() {
+    pull();
+    block_->buckets[0].pop_back();
+    --block_->size;
+  }
+
+  size_t size() const {
+    return block_ ? block_->size : 0;
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  void clear() {
+    block_.reset();
+  }
+
+  void swap(compact_radix_heap<KeyType, EncoderType> &a) {
+    block_.swap(a.block_);
+  }
+
+ private:
+  typedef internal::compact_bucket_block<unsigned_key_type, unsigned_key_type> block_type;
+  std::unique_ptr<block_type> block_;
+
+  void pull() {
+    assert(size() > 0);
+    block_type &b = *block_;
+    if (!b.buckets[0].empty()) return;
+
+    size_t i;
+    for (i = 1; b.buckets[i].empty(); ++i);
+    b.last = b.buckets_min[i];
+
+    for (size_t j = 0; j < b.buckets[i].size(); ++j) {
+      const unsigned_key_type x = b.buckets[i][j];
+      const size_t k = internal::find_bucket(x, b.last);
+      b.buckets[k].emplace_back(x);
+      b.buckets_min[k] = std::min(b.buckets_min[k], x);
+    }
+    b.buckets[i].clear();
+    b.buckets_min[i] = internal::key_traits<unsigned_key_type>::max();
+  }
+};
+
+// |pair_radix_heap| with a pointer-sized header. See |compact_radix_heap|.
+template<typename KeyType, typename ValueType, typename EncoderType = internal::encoder<KeyType>>
+class compact_pair_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+
+  compact_pair_radix_heap() {}
+
+  compact_pair_radix_heap(const compact_pair_radix_heap &h)
+      : block_(h.block_ ? new block_type(*h.block_) : NULL) {}
+
+  compact_pair_radix_heap(compact_pair_radix_heap &&h) = default;
+
+  compact_pair_radix_heap &operator=(compact_pair_radix_heap h) {
+    swap(h);
+    return *this;
+  }
+
+  void push(key_type key, const value_type &value) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    if (!block_) block_.reset(new block_type());
+    assert(block_->last <= x);
+    ++block_->size;
+    const size_t k = internal::find_bucket(x, block_->last);
+    block_->buckets[k].emplace_back(x, value);
+    block_->buckets_min[k] = std::min(block_->buckets_min[k], x);
+  }
+
+  void push(key_type key, value_type &&value) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    if (!block_) block_.reset(new block_type());
+    assert(block_->last <= x);
+    ++block_->size;
+    const size_t k = internal::find_bucket(x, block_->last);
+    block_->buckets[k].emplace_back(x, std::move(value));
+    block_->buckets_min[k] = std::min(block_->buckets_min[k], x);
+  }
+
+  template <class... Args>
+  void emplace(key_type key, Args&&... args) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    if (!block_) block_.reset(new block_type());
+    assert(block_->last <= x);
+    ++block_->size;
+    const size_t k = internal::find_bucket(x, block_->last);
+    block_->buckets[k].emplace_back(std::piecewise_construct,
+                                    std::forward_as_tuple(x),
+                                    std::forward_as_tuple(std::forward<Args>(args)...));
+    block_->buckets_min[k] = std::min(block_->buckets_min[k], x);
+  }
+
+  key_type top_key() {
+    pull();
+    return encoder_type::decode(block_->last);
+  }
+
+  value_type &top_value() {
+    pull();
+    return block_->buckets[0].back().second;
+  }
+
+  void pop() {
+    pull();
+    block_->buckets[0].pop_back();
+    --block_->size;
+  }
+
+  size_t size() const {
+    return block_ ? block_->size : 0;
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  void clear() {
+    block_.reset();
+  }
+
+  void swap(compact_pair_radix_heap<KeyType, ValueType, EncoderType> &a) {
+    block_.swap(a.block_);
+  }
+
+ private:
+  typedef internal::compact_bucket_block
+  <std::pair<unsigned_key_type, value_type>, unsigned_key_type> block_type;
+  std::unique_ptr<block_type> block_;
+
+  void pull() {
+    assert(size() > 0);
+    block_type &b = *block_;
+    if (!b.buckets[0].empty()) return;
+
+    size_t i;
+    for (i = 1; b.buckets[i].empty(); ++i);
+    b.last = b.buckets_min[i];
+
+    for (size_t j = 0; j < b.buckets[i].size(); ++j) {
+      const unsigned_key_type x = b.buckets[i][j].first;
+      const size_t k = internal::find_bucket(x, b.last);
+      b.buckets[k].emplace_back(std::move(b.buckets[i][j]));
+      b.buckets_min[k] = std::min(b.buckets_min[k], x);
+    }
+    b.buckets[i].clear();
+    b.buckets_min[i] = internal::key_traits<unsigned_key_type>::max();
+  }
+};
+
+// |radix_heap| which keeps up to |SmallSize| keys in an inline sorted array
+// and uses radix buckets only when it grows beyond that. It returns to the
+// inline array once the buckets become empty.
+template<typename KeyType, size_t SmallSize = 16, typename EncoderType = internal::encoder<KeyType>>
+class small_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+  typedef radix_heap<KeyType, EncoderType> large_heap_type;
+
+  small_radix_heap() : small_size_(0), last_() {}
+
+  small_radix_heap(const small_radix_heap &h)
+      : small_size_(h.small_size_), last_(h.last_), small_(h.small_),
+        large_(h.large_ ? new large_heap_type(*h.large_) : NULL) {}
+
+  small_radix_heap(small_radix_heap &&h)
+      : small_size_(h.small_size_), last_(h.last_), small_(h.small_),
+        large_(std::move(h.large_)) {
+    h.small_size_ = 0;
+    h.last_ = unsigned_key_type();
+  }
+
+  small_radix_heap &operator=(small_radix_heap h) {
+    swap(h);
+    return *this;
+  }
+
+  void push(key_type key) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    assert(last_ <= x);
+    if (large_ && !large_->empty()) {
+      large_->push(key);
+      return;
+    }
+    if (small_size_ == SmallSize) {
+      if (!large_) large_.reset(new large_heap_type());
+      for (size_t i = 0; i < small_size_; ++i) {
+        large_->push(encoder_type::decode(small_[i]));
+      }
+      small_size_ = 0;
+      large_->push(key);
+      return;
+    }
+
+    // Sorted in descending order so that the minimum is at the back.
+    size_t i = small_size_++;
+    for (; i > 0 && small_[i - 1] < x; --i) small_[i] = small_[i - 1];
+    small_[i] = x;
+  }
+
+  key_type top() {
+    pull();
+    return encoder_type::decode(last_);
+  }
+
+  void pop() {
+    pull();
+    if (small_size_ > 0) --small_size_;
+    else large_->pop();
+  }
+
+  size_t size() const {
+    return small_size_ + (large_ ? large_->size() : 0);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  void clear() {
+    small_size_ = 0;
+    last_ = unsigned_key_type();
+    if (large_) large_->clear();
+  }
+
+  void swap(small_radix_heap<KeyType, SmallSize, EncoderType> &a) {
+    std::swap(small_size_, a.small_size_);
+    std::swap(last_, a.last_);
+    small_.swap(a.small_);
+    large_.swap(a.large_);
+  }
+
+ private:
+  size_t small_size_;
+  unsigned_key_type last_;
+  std::array<unsigned_key_type, SmallSize> small_;
+  std::unique_ptr<large_heap_type> large_;
+
+  void pull() {
+    assert(!empty());
+    if (small_size_ > 0) last_ = small_[small_size_ - 1];
+    else last_ = encoder_type::encode(large_->top());
+  }
+};
+
+// |pair_radix_heap| which keeps up to |SmallSize| pairs in an inline sorted
+// array. See |small_radix_heap|.
+template<typename KeyType, typename ValueType, size_t SmallSize = 16,
+         typename EncoderType = internal::encoder<KeyType>>
+class small_pair_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+  typedef pair_radix_heap<KeyType, ValueType, EncoderType> large_heap_type;
+
+  small_pair_radix_heap() : small_size_(0), last_() {}
+
+  small_pair_radix_heap(const small_pair_radix_heap &h)
+      : small_size_(0), last_(h.last_),
+        large_(h.large_ ? new large_heap_type(*h.large_) : NULL) {
+    for (; small_size_ < h.small_size_; ++small_size_) {
+      new (small_data() + small_size_) element_type(h.small_data()[small_size_]);
+    }
+  }
+
+  small_pair_radix_heap(small_pair_radix_heap &&h) : small_size_(0), last_() {
+    move_from(h);
+  }
+
+  ~small_pair_radix_heap() {
+    clear_small();
+  }
+
+  small_pair_radix_heap &operator=(small_pair_radix_heap h) {
+    swap(h);
+    return *this;
+  }
+
+  void push(key_type key, const value_type &value) {
+    emplace(key, value);
+  }
+
+  void push(key_type key, value_type &&value) {
+    emplace(key, std::move(value));
+  }
+
+  template <class... Args>
+  void emplace(key_type key, Args&&... args) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    assert(last_ <= x);
+    if (large_ && !large_->empty()) {
+      large_->emplace(key, std::forward<Args>(args)...);
+      return;
+    }
+
+    // Built before the elements move, as |args| may refer to one of them.
+    element_type e(std::piecewise_construct,
+                   std::forward_as_tuple(x),
+                   std::forward_as_tuple(std::forward<Args>(args)...));
+    if (small_size_ == SmallSize) {
+      if (!large_) large_.reset(new large_heap_type());
+      for (size_t i = 0; i < small_size_; ++i) {
+        large_->push(encoder_type::decode(small_data()[i].first), std::move(small_data()[i].second));
+      }
+      clear_small();
+      large_->push(key, std::move(e.second));
+      return;
+    }
+
+    // Sorted in descending order so that the minimum is at the back.
+    element_type *a = small_data();
+    size_t i = small_size_;
+    if (i > 0 && a[i - 1].first < x) {
+      new (a + i) element_type(std::move(a[i - 1]));
+      for (--i; i > 0 && a[i - 1].first < x; --i) a[i] = std::move(a[i - 1]);
+      a[i] = std::move(e);
+    } else {
+      new (a + i) element_type(std::move(e));
+    }
+    ++small_size_;
+  }
+
+  key_type top_key() {
+    pull();
+    return encoder_type::decode(last_);
+  }
+
+  value_type &top_value() {
+    pull();
+    if (small_size_ > 0) return small_data()[small_size_ - 1].second;
+    else return large_->top_value();
+  }
+
+  void pop() {
+    pull();
+    if (small_size_ > 0) small_data()[--small_size_].~element_type();
+    else large_->pop();
+  }
+
+  size_t size() const {
+    return small_size_ + (large_ ? large_->size() : 0);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  void clear() {
+    clear_small();
+    last_ = unsigned_key_type();
+    if (large_) large_->clear();
+  }
+
+  void swap(small_pair_radix_heap<KeyType, ValueType, SmallSize, EncoderType> &a) {
+    small_pair_radix_heap t(std::move(a));
+    a.move_from(*this);
+    move_from(t);
+  }
+
+ private:
+  typedef std::pair<unsigned_key_type, value_type> element_type;
+
+  size_t small_size_;
+  unsigned_key_type last_;
+  typename std::aligned_storage<sizeof(element_type) * SmallSize,
+                                alignof(element_type)>::type small_;
+  std::unique_ptr<large_heap_type> large_;
+
+  element_type *small_data() {
+    return reinterpret_cast<element_type*>(&small_);
+  }
+
+  const element_type *small_data() const {
+    return reinterpret_cast<const element_type*>(&small_);
+  }
+
+  void clear_small() {
+    for (size_t i = 0; i < small_size_; ++i) small_data()[i].~element_type();
+    small_size_ = 0;
+  }
+
+  void move_from(small_pair_radix_heap &h) {
+    clear_small();
+    for (; small_size_ < h.small_size_; ++small_size_) {
+      new (small_data() + small_size_) element_type(std::move(h.small_data()[small_size_]));
+    }
+    h.clear_small();
+    last_ = h.last_;
+    large_ = std::move(h.large_);
+  }
+
+  void pull() {
+    assert(!empty());
+    if (small_size_ > 0) last_ = small_data()[small_size_ - 1].first;
+    else last_ = encoder_type::encode(large_->top_key());
+  }
+};
+
+// A |radix_heap| of unsigned keys compared by serial number arithmetic
+// (RFC 1982), e.g., 32-bit tick counters which wrap around. A key |a| is
+// less than |b| if |b - a| modulo 2^digits is in (0, 2^(digits - 1)).
+// Pushed keys must not be less than the last extracted key, and alive keys
+// must span less than 2^(digits - 1). Until the first extraction, keys are
+// compared with |origin| given to the constructor or |clear|, e.g., the
+// current tick.
+//
+// Keys are stored relative to a base. Once the last extracted key gets
+// 2^(digits - 1) away from the base, the next push moves the base to it,
+// re-pushing the elements, so it takes time linear in their number only once
+// per half of the key space.
+template<typename KeyType = uint32_t>
+class serial_radix_heap {
+ public:
+  typedef KeyType key_type;
+
+  static_assert(std::is_unsigned<key_type>::value, "key_type must be unsigned");
+
+  explicit serial_radix_heap(key_type origin = key_type()) : base_(origin), last_(origin) {}
+
+  void push(key_type key) {
+    heap_.push(relative(key));
+  }
+
+  key_type top() {
+    last_ = key_type(heap_.top() + base_);
+    return last_;
+  }
+
+  void pop() {
+    top();
+    heap_.pop();
+  }
+
+  size_t size() const {
+    return heap_.size();
+  }
+
+  bool empty() const {
+    return heap_.empty();
+  }
+
+  void clear(key_type origin = key_type()) {
+    heap_.clear();
+    base_ = last_ = origin;
+  }
+
+  void swap(serial_radix_heap<KeyType> &a) {
+    heap_.swap(a.heap_);
+    std::swap(base_, a.base_);
+    std::swap(last_, a.last_);
+  }
+
+ private:
+  static constexpr key_type kHalf = key_type(1) << (internal::key_traits<key_type>::digits - 1);
+
+  // |spare_| receives the elements on rebasing and keeps its storage
+  // for the next time.
+  radix_heap<key_type> heap_, spare_;
+  key_type base_, last_;
+
+  // Returns |key| relative to the base, moving the base if needed.
+  key_type relative(key_type key) {
+    assert(key_type(key - last_) < kHalf);
+    if (key_type(last_ - base_) >= kHalf) rebase();
+    return key_type(key - base_);
+  }
+
+  void rebase() {
+    const key_type d = key_type(last_ - base_);
+    spare_.clear();
+    for (; !heap_.empty(); heap_.pop()) spare_.push(key_type(heap_.top() - d));
+    heap_.swap(spare_);
+    base_ = last_;
+  }
+};
+
+template<typename KeyType>
+constexpr KeyType serial_radix_heap<KeyType>::kHalf;
+
+// A |pair_radix_heap| of unsigned keys compared by serial number arithmetic.
+// See |serial_radix_heap|.
+template<typename KeyType, typename ValueType>
+class serial_pair_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+
+  static_assert(std::is_unsigned<key_type>::value, "key_type must be unsigned");
+
+  explicit serial_pair_radix_heap(key_type origin = key_type()) : base_(origin), last_(origin) {}
+
+  void push(key_type key, const value_type &value) {
+    heap_.push(relative(key), value);
+  }
+
+  void push(key_type key, value_type &&value) {
+    heap_.push(relative(key), std::move(value));
+  }
+
+  template <class... Args>
+  void emplace(key_type key, Args&&... args) {
+    heap_.emplace(relative(key), std::forward<Args>(args)...);
+  }
+
+  key_type top_key() {
+    last_ = key_type(heap_.top_key() + base_);
+    return last_;
+  }
+
+  value_type &top_value() {
+    top_key();
+    return heap_.top_value();
+  }
+
+  void pop() {
+    top_key();
+    heap_.pop();
+  }
+
+  // See |pair_radix_heap::pop_top_group|.
+  key_type pop_top_group(std::vector<value_type> &values) {
+    last_ = key_type(heap_.pop_top_group(values) + base_);
+    return last_;
+  }
+
+  size_t size() const {
+    return heap_.size();
+  }
+
+  bool empty() const {
+    return heap_.empty();
+  }
+
+  void clear(key_type origin = key_type()) {
+    heap_.clear();
+    base_ = last_ = origin;
+  }
+
+  void swap(serial_pair_radix_heap<KeyType, ValueType> &a) {
+    heap_.swap(a.heap_);
+    std::swap(base_, a.base_);
+    std::swap(last_, a.last_);
+  }
+
+ private:
+  static constexpr key_type kHalf = key_type(1) << (internal::key_traits<key_type>::digits - 1);
+
+  // See |serial_radix_heap|.
+  pair_radix_heap<key_type, value_type> heap_, spare_;
+  key_type base_, last_;
+
+  // Returns |key| relative to the base, moving the base if needed.
+  key_type relative(key_type key) {
+    assert(key_type(key - last_) < kHalf);
+    if (key_type(last_ - base_) >= kHalf) rebase();
+    return key_type(key - base_);
+  }
+
+  void rebase() {
+    const key_type d = key_type(last_ - base_);
+    spare_.clear();
+    for (; !heap_.empty(); heap_.pop()) {
+      spare_.push(key_type(heap_.top_key() - d), std::move(heap_.top_value()));
+    }
+    heap_.swap(spare_);
+    base_ = last_;
+  }
+};
+
+template<typename KeyType, typename ValueType>
+constexpr KeyType serial_pair_radix_heap<KeyType, ValueType>::kHalf;
+
+// The result of pushing into |soft_radix_heap| and |soft_pair_radix_heap|.
+enum class push_status {
+  on_time,   // Not less than the last extracted key.
+  late,      // Less than the last extracted key, but within the window.
+  rejected,  // Older than the window. The element is not pushed.
+};
+
+// A |radix_heap| accepting keys up to |window| behind the last extracted key,
+// for almost monotone streams. The window is measured in the encoded key
+// space, which is the difference of keys for integers and the number of
+// ticks for |std::chrono| types.
+//
+// On-time keys go into the radix heap as usual. Late keys go into a small
+// binary heap, which is drained first, as late keys are less than every key
+// in the radix heap.
+template<typename KeyType, typename EncoderType = internal::encoder<KeyType>>
+class soft_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+
+  explicit soft_radix_heap(unsigned_key_type window) : window_(window), last_() {}
+
+  push_status push(key_type key) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    if (last_ <= x) {
+      heap_.push(key);
+      return push_status::on_time;
+    }
+    if (unsigned_key_type(last_ - x) > window_) return push_status::rejected;
+    late_.push_back(x);
+    std::push_heap(late_.begin(), late_.end(), std::greater<unsigned_key_type>());
+    return push_status::late;
+  }
+
+  key_type top() {
+    if (!late_.empty()) return encoder_type::decode(late_.front());
+    const key_type key = heap_.top();
+    last_ = encoder_type::encode(key);
+    return key;
+  }
+
+  void pop() {
+    if (!late_.empty()) {
+      std::pop_heap(late_.begin(), late_.end(), std::greater<unsigned_key_type>());
+      late_.pop_back();
+    } else {
+      top();
+      heap_.pop();
+    }
+  }
+
+  size_t size() const {
+    return heap_.size() + late_.size();
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  unsigned_key_type window() const {
+    return window_;
+  }
+
+  void clear() {
+    heap_.clear();
+    late_.clear();
+    last_ = unsigned_key_type();
+  }
+
+  void swap(soft_radix_heap<KeyType, EncoderType> &a) {
+    heap_.swap(a.heap_);
+    late_.swap(a.late_);
+    std::swap(window_, a.window_);
+    std::swap(last_, a.last_);
+  }
+
+ private:
+  radix_heap<key_type, encoder_type> heap_;
+  std::vector<unsigned_key_type> late_;
+  unsigned_key_type window_;
+  // The last key pulled from |heap_|.
+  unsigned_key_type last_;
+};
+
+// A |pair_radix_heap| accepting keys up to |window| behind the last extracted
+// key. See |soft_radix_heap|.
+template<typename KeyType, typename ValueType, typename EncoderType = internal::encoder<KeyType>>
+class soft_pair_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+
+  explicit soft_pair_radix_heap(unsigned_key_type window) : window_(window), last_() {}
+
+  push_status push(key_type key, const value_type &value) {
+    return emplace(key, value);
+  }
+
+  push_status push(key_type key, value_type &&value) {
+    return emplace(key, std::move(value));
+  }
+
+  template <class... Args>
+  push_status emplace(key_type key, Args&&... args) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    if (last_ <= x) {
+      heap_.emplace(key, std::forward<Args>(args)...);
+      return push_status::on_time;
+    }
+    if (unsigned_key_type(last_ - x) > window_) return push_status::rejected;
+    late_.emplace_back(std::piecewise_construct,
+                       std::forward_as_tuple(x),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+    std::push_heap(late_.begin(), late_.end(), later());
+    return push_status::late;
+  }
+
+  key_type top_key() {
+    if (!late_.empty()) return encoder_type::decode(late_.front().first);
+    const key_type key = heap_.top_key();
+    last_ = encoder_type::encode(key);
+    return key;
+  }
+
+  value_type &top_value() {
+    if (!late_.empty()) return late_.front().second;
+    top_key();
+    return heap_.top_value();
+  }
+
+  void pop() {
+    if (!late_.empty()) {
+      std::pop_heap(late_.begin(), late_.end(), later());
+      late_.pop_back();
+    } else {
+      top_key();
+      heap_.pop();
+    }
+  }
+
+  size_t size() const {
+    return heap_.size() + late_.size();
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  unsigned_key_type window() const {
+    return window_;
+  }
+
+  void clear() {
+    heap_.clear();
+    late_.clear();
+    last_ = unsigned_key_type();
+  }
+
+  void swap(soft_pair_radix_heap<KeyType, ValueType, EncoderType> &a) {
+    heap_.swap(a.heap_);
+    late_.swap(a.late_);
+    std::swap(window_, a.window_);
+    std::swap(last_, a.last_);
+  }
+
+ private:
+  typedef std::pair<unsigned_key_type, value_type> element_type;
+
+  struct later {
+    bool operator()(const element_type &a, const element_type &b) const {
+      return a.first > b.first;
+    }
+  };
+
+  pair_radix_heap<key_type, value_type, encoder_type> heap_;
+  std::vector<element_type> late_;
+  unsigned_key_type window_;
+  // The last key pulled from |heap_|.
+  unsigned_key_type last_;
 };
 }  // namespace radix_heap
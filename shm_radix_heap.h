@@ -0,0 +1,235 @@
+#pragma once
+#include "radix_heap.h"
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+
+namespace radix_heap {
+// A |pair_radix_heap| living entirely in a caller-supplied memory segment,
+// e.g., one mapped by |shm_open| and |mmap| in several processes. Elements
+// are kept in a fixed pool of |capacity| nodes, and buckets are linked lists
+// of node indices rather than pointers, so the segment may be mapped at
+// different addresses. Values must be trivially copyable.
+//
+// An instance is a handle to a segment. |create| initializes a segment and
+// |attach| opens an initialized one; the segment itself holds all the state.
+// Every operation takes a process-shared mutex. On Linux the mutex is robust:
+// if a process dies while holding it, the next process rebuilds the buckets
+// from the nodes marked as used and continues.
+template<typename KeyType, typename ValueType, typename EncoderType = internal::encoder<KeyType>>
+class shm_pair_radix_heap {
+ public:
+  typedef KeyType key_type;
+  typedef ValueType value_type;
+  typedef typename internal::encoder_of<KeyType, EncoderType>::type encoder_type;
+  typedef typename encoder_type::unsigned_key_type unsigned_key_type;
+
+#if defined(__GLIBCXX__) && !defined(_GLIBCXX_RELEASE)
+  // libstdc++ before 5 lacks |std::is_trivially_copyable|.
+  static_assert(__has_trivial_copy(value_type), "value_type must be trivially copyable");
+#else
+  static_assert(std::is_trivially_copyable<value_type>::value,
+                "value_type must be trivially copyable");
+#endif
+
+  // The number of bytes of a segment holding up to |capacity| elements.
+  static size_t required_bytes(uint32_t capacity) {
+    return nodes_offset() + sizeof(node) * capacity;
+  }
+
+  // Initializes a heap in |segment| of at least |required_bytes(capacity)|
+  // bytes. Only one process should call it, before others |attach|.
+  static shm_pair_radix_heap create(void *segment, uint32_t capacity) {
+    header *h = static_cast<header*>(segment);
+    h->magic = 0;
+    h->capacity = capacity;
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#ifdef __linux__
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#endif
+    pthread_mutex_init(&h->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    shm_pair_radix_heap res(h);
+    node *nodes = res.nodes();
+    for (uint32_t i = 0; i < capacity; ++i) nodes[i].used = 0;
+    h->last = unsigned_key_type();
+    res.rebuild();
+    h->magic = kMagic;
+    return res;
+  }
+
+  // Opens a heap initialized by |create|.
+  static shm_pair_radix_heap attach(void *segment) {
+    header *h = static_cast<header*>(segment);
+    assert(h->magic == kMagic);
+    return shm_pair_radix_heap(h);
+  }
+
+  // Returns false if the pool is full.
+  bool push(key_type key, const value_type &value) {
+    const unsigned_key_type x = encoder_type::encode(key);
+    lock_guard lock(header_);
+    assert(header_->last <= x);
+    const uint32_t i = header_->free_head;
+    if (i == kNull) return false;
+    node &n = nodes()[i];
+    header_->free_head = n.next;
+    n.key = x;
+    memcpy(&n.value, &value, sizeof(value_type));
+    n.used = 1;
+    link(i);
+    ++header_->size;
+    return true;
+  }
+
+  // Pops the minimum. Returns false if the heap is empty.
+  bool try_pop(key_type *key, value_type *value) {
+    lock_guard lock(header_);
+    if (header_->size == 0) return false;
+    pull();
+    const uint32_t i = header_->heads[0];
+    node &n = nodes()[i];
+    *key = encoder_type::decode(n.key);
+    memcpy(value, &n.value, sizeof(value_type));
+    n.used = 0;
+    header_->heads[0] = n.next;
+    n.next = header_->free_head;
+    header_->free_head = i;
+    --header_->size;
+    return true;
+  }
+
+  size_t size() const {
+    lock_guard lock(header_);
+    return header_->size;
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  uint32_t capacity() const {
+    return header_->capacity;
+  }
+
+  void clear() {
+    lock_guard lock(header_);
+    node *ns = nodes();
+    for (uint32_t i = 0; i < header_->capacity; ++i) ns[i].used = 0;
+    header_->last = unsigned_key_type();
+    rebuild();
+  }
+
+ private:
+  static constexpr uint64_t kMagic = 0x7261646978686570ULL ^ (sizeof(unsigned_key_type) << 8 | sizeof(value_type));
+  static constexpr uint32_t kNull = std::numeric_limits<uint32_t>::max();
+  static constexpr size_t kNumBuckets = internal::key_traits<unsigned_key_type>::digits + 1;
+
+  struct header {
+    uint64_t magic;
+    pthread_mutex_t mutex;
+    uint32_t capacity;
+    uint32_t free_head;
+    uint64_t size;
+    unsigned_key_type last;
+    uint32_t heads[kNumBuckets];
+    unsigned_key_type buckets_min[kNumBuckets];
+  };
+
+  struct node {
+    unsigned_key_type key;
+    uint32_t next;
+    uint32_t used;
+    value_type value;
+  };
+
+  class lock_guard {
+   public:
+    explicit lock_guard(header *h) : h_(h) {
+      const int r = pthread_mutex_lock(&h_->mutex);
+#ifdef __linux__
+      if (r == EOWNERDEAD) {
+        // The previous owner died in the middle of an operation.
+        shm_pair_radix_heap(h_).rebuild();
+        pthread_mutex_consistent(&h_->mutex);
+      }
+#else
+      (void)r;
+#endif
+    }
+    ~lock_guard() {
+      pthread_mutex_unlock(&h_->mutex);
+    }
+
+   private:
+    header *h_;
+  };
+
+  header *header_;
+
+  explicit shm_pair_radix_heap(header *h) : header_(h) {}
+
+  static constexpr size_t nodes_offset() {
+    return (sizeof(header) + alignof(node) - 1) / alignof(node) * alignof(node);
+  }
+
+  node *nodes() const {
+    return reinterpret_cast<node*>(reinterpret_cast<char*>(header_) + nodes_offset());
+  }
+
+  void link(uint32_t i) {
+    node &n = nodes()[i];
+    const size_t k = internal::find_bucket(n.key, header_->last);
+    n.next = header_->heads[k];
+    header_->heads[k] = i;
+    header_->buckets_min[k] = std::min(header_->buckets_min[k], n.key);
+  }
+
+  // Restores the free list and the buckets from the |used| marks of nodes.
+  // |last| is kept, as it is at most every used key even if the previous
+  // owner died in the middle of |pull|, and later pushes may be less than the
+  // minimum used key.
+  void rebuild() {
+    node *ns = nodes();
+    header_->size = 0;
+    header_->free_head = kNull;
+    for (size_t k = 0; k < kNumBuckets; ++k) {
+      header_->heads[k] = kNull;
+      header_->buckets_min[k] = internal::key_traits<unsigned_key_type>::max();
+    }
+    for (uint32_t i = header_->capacity; i-- > 0; ) {
+      if (ns[i].used) {
+        ++header_->size;
+      } else {
+        ns[i].next = header_->free_head;
+        header_->free_head = i;
+      }
+    }
+    for (uint32_t i = 0; i < header_->capacity; ++i) {
+      if (ns[i].used) link(i);
+    }
+  }
+
+  void pull() {
+    assert(header_->size > 0);
+    if (header_->heads[0] != kNull) return;
+
+    size_t i;
+    for (i = 1; header_->heads[i] == kNull; ++i);
+    header_->last = header_->buckets_min[i];
+
+    uint32_t j = header_->heads[i];
+    header_->heads[i] = kNull;
+    header_->buckets_min[i] = internal::key_traits<unsigned_key_type>::max();
+    while (j != kNull) {
+      const uint32_t next = nodes()[j].next;
+      link(j);
+      j = next;
+    }
+  }
+};
+}  // namespace radix_heap
@@ -0,0 +1,250 @@
+#pragma once
+#include "radix_heap.h"
+#include <string>
+
+namespace radix_heap {
+namespace internal {
+// Returns the length of the longest common prefix of |a| and |b|, which are
+// known to share their first |from| bytes. Compares 8 bytes at a time.
+inline size_t common_prefix_length(const char *a, size_t a_size,
+                                   const char *b, size_t b_size, size_t from) {
+  const size_t n = std::min(a_size, b_size);
+  size_t i = from;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t x, y;
+    memcpy(&x, a + i, 8);
+    memcpy(&y, b + i, 8);
+    if (x != y) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      return i + __builtin_clzll(x ^ y) / 8;
+#else
+      return i + __builtin_ctzll(x ^ y) / 8;
+#endif
+    }
+  }
+  for (; i < n && a[i] == b[i]; ++i);
+  return i;
+}
+
+// Whether |a| is lexicographically less than |b|, where bytes are compared
+// as unsigned as by |std::string::compare|.
+inline bool string_less(const char *a, size_t a_size,
+                        const char *b, size_t b_size, size_t from) {
+  const size_t i = common_prefix_length(a, a_size, b, b_size, from);
+  if (i == std::min(a_size, b_size)) return a_size < b_size;
+  return static_cast<unsigned char>(a[i]) < static_cast<unsigned char>(b[i]);
+}
+}  // namespace internal
+
+// A monotone priority queue of byte strings paired with values, e.g., for
+// merging sorted runs of keys. Pushed keys must not be less than the last
+// extracted key |last_|.
+//
+// A key is placed by the length |l| of its common prefix with |last_| and
+// by its byte at |l|. Keys in the bucket of the longest |l| and the smallest
+// byte are the smallest ones. When that bucket is pulled, its minimum becomes
+// |last_| and its keys move to buckets of longer prefixes, so each key is
+// moved at most as many times as its length. The other buckets do not need
+// to be touched, as their prefixes with the new |last_| are unchanged.
+//
+// Key bytes are kept in an arena, which is compacted when more than half of
+// it is occupied by popped keys. Each level of buckets, i.e., each length of
+// common prefixes up to the length of |last_|, takes 256 vectors.
+template<typename ValueType>
+class string_radix_heap {
+ public:
+  typedef std::string key_type;
+  typedef ValueType value_type;
+
+  string_radix_heap() : size_(0), dead_bytes_(0), levels_(1), level_mask_(1) {}
+
+  void push(const key_type &key, const value_type &value) {
+    add(key.data(), key.size(), value);
+  }
+
+  void push(const key_type &key, value_type &&value) {
+    add(key.data(), key.size(), std::move(value));
+  }
+
+  void push(const char *key, size_t key_size, const value_type &value) {
+    add(key, key_size, value);
+  }
+
+  void push(const char *key, size_t key_size, value_type &&value) {
+    add(key, key_size, std::move(value));
+  }
+
+  template <class... Args>
+  void emplace(const key_type &key, Args&&... args) {
+    add(key.data(), key.size(), std::forward<Args>(args)...);
+  }
+
+  const key_type &top_key() {
+    pull();
+    return last_;
+  }
+
+  value_type &top_value() {
+    pull();
+    return equal_.back().value;
+  }
+
+  void pop() {
+    pull();
+    dead_bytes_ += equal_.back().size;
+    equal_.pop_back();
+    --size_;
+    if (dead_bytes_ >= kMinCompactionBytes && dead_bytes_ * 2 > arena_.size()) compact();
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    size_ = 0;
+    dead_bytes_ = 0;
+    last_.clear();
+    arena_.clear();
+    equal_.clear();
+    for (size_t l = 0; l < levels_.size(); ++l) {
+      if (levels_[l].empty()) continue;
+      for (auto &b : levels_[l].buckets) b.clear();
+      levels_[l].mask.fill(0);
+    }
+    std::fill(level_mask_.begin(), level_mask_.end(), 0);
+  }
+
+  void swap(string_radix_heap<ValueType> &a) {
+    std::swap(size_, a.size_);
+    std::swap(dead_bytes_, a.dead_bytes_);
+    last_.swap(a.last_);
+    arena_.swap(a.arena_);
+    equal_.swap(a.equal_);
+    levels_.swap(a.levels_);
+    level_mask_.swap(a.level_mask_);
+  }
+
+ private:
+  static constexpr size_t kMinCompactionBytes = 1 << 16;
+
+  struct node {
+    size_t offset, size;
+    value_type value;
+
+    template <class... Args>
+    node(size_t offset, size_t size, Args&&... args)
+        : offset(offset), size(size), value(std::forward<Args>(args)...) {}
+  };
+
+  // Buckets of keys sharing a prefix of the same length with |last_|,
+  // indexed by the byte following the prefix.
+  struct level {
+    std::array<std::vector<node>, 256> buckets;
+    std::array<uint64_t, 4> mask;
+
+    level() { mask.fill(0); }
+
+    bool empty() const {
+      return (mask[0] | mask[1] | mask[2] | mask[3]) == 0;
+    }
+  };
+
+  size_t size_;
+  size_t dead_bytes_;
+  key_type last_;
+  std::vector<char> arena_;
+  // Keys equal to |last_|.
+  std::vector<node> equal_;
+  std::vector<level> levels_;
+  std::vector<uint64_t> level_mask_;
+
+  template <class... Args>
+  void add(const char *key, size_t key_size, Args&&... args) {
+    assert(!internal::string_less(key, key_size, last_.data(), last_.size(), 0));
+    const size_t offset = arena_.size();
+    arena_.insert(arena_.end(), key, key + key_size);
+    ++size_;
+    link(node(offset, key_size, std::forward<Args>(args)...), 0);
+  }
+
+  // Places |n|, whose key shares its first |from| bytes with |last_|.
+  void link(node &&n, size_t from) {
+    const char *key = arena_.data() + n.offset;
+    const size_t l = internal::common_prefix_length(key, n.size, last_.data(), last_.size(), from);
+    if (l == n.size) {
+      assert(n.size == last_.size());
+      equal_.push_back(std::move(n));
+      return;
+    }
+
+    const unsigned char c = key[l];
+    level &lv = levels_[l];
+    lv.buckets[c].push_back(std::move(n));
+    lv.mask[c / 64] |= uint64_t(1) << (c % 64);
+    level_mask_[l / 64] |= uint64_t(1) << (l % 64);
+  }
+
+  void pull() {
+    assert(size_ > 0);
+    if (!equal_.empty()) return;
+
+    size_t w = level_mask_.size() - 1;
+    for (; level_mask_[w] == 0; --w);
+    const size_t l = w * 64 + 63 - __builtin_clzll(level_mask_[w]);
+    size_t v = 0;
+    for (; levels_[l].mask[v] == 0; ++v);
+    const size_t c = v * 64 + __builtin_ctzll(levels_[l].mask[v]);
+
+    std::vector<node> bucket;
+    bucket.swap(levels_[l].buckets[c]);
+    levels_[l].mask[v] &= levels_[l].mask[v] - 1;
+    if (levels_[l].empty()) level_mask_[w] &= ~(uint64_t(1) << (l % 64));
+
+    // All the keys in the bucket share their first |l + 1| bytes.
+    size_t m = 0;
+    for (size_t i = 1; i < bucket.size(); ++i) {
+      if (internal::string_less(arena_.data() + bucket[i].offset, bucket[i].size,
+                                arena_.data() + bucket[m].offset, bucket[m].size, l + 1)) {
+        m = i;
+      }
+    }
+    last_.assign(arena_.data() + bucket[m].offset, bucket[m].size);
+    if (levels_.size() < last_.size() + 1) {
+      levels_.resize(last_.size() + 1);
+      level_mask_.resize(last_.size() / 64 + 1);
+    }
+
+    for (auto &n : bucket) link(std::move(n), l + 1);
+    bucket.clear();
+    levels_[l].buckets[c].swap(bucket);
+  }
+
+  // Moves keys in use to the front of a new arena.
+  void compact() {
+    std::vector<char> arena;
+    arena.reserve(arena_.size() - dead_bytes_);
+    auto move = [&](node &n) {
+      const size_t offset = arena.size();
+      arena.insert(arena.end(), arena_.begin() + n.offset, arena_.begin() + n.offset + n.size);
+      n.offset = offset;
+    };
+    for (auto &n : equal_) move(n);
+    for (size_t l = 0; l < levels_.size(); ++l) {
+      if (levels_[l].empty()) continue;
+      for (auto &b : levels_[l].buckets) {
+        for (auto &n : b) move(n);
+      }
+    }
+    arena_.swap(arena);
+    dead_bytes_ = 0;
+  }
+};
+
+template<typename ValueType>
+constexpr size_t string_radix_heap<ValueType>::kMinCompactionBytes;
+}  // namespace radix_heap
@@ -1,5 +1,13 @@
 #include "radix_heap.h"
+#include "huge_page_allocator.h"
+#include "concurrent_radix_heap.h"
+#include "shm_radix_heap.h"
+#include "string_radix_heap.h"
+#include "timer_queue.h"
 #include <queue>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "gtest/gtest.h"
 using namespace std;
 using testing::Types;
@@ -28,7 +36,7 @@ typedef Types<unsigned char, char, signed char,
               unsigned int, int,
               unsigned long, long,
               unsigned long long, long long,
-              float, double> AllTypes;
+              float, double, long double> AllTypes;
 }  // namespace
 
 template<typename T>
@@ -205,6 +213,671 @@ TEST(radix_heap_test_int, large) {
   }
 }
 
+#ifdef __SIZEOF_INT128__
+TEST(radix_heap_test_int128, large) {
+  typedef radix_heap::internal::int128_t int128_t;
+  const int kNumPop = 100000;
+
+  radix_heap::radix_heap<int128_t> rh;
+  priority_queue<int128_t, vector<int128_t>, greater<int128_t>> pq;
+  // Keys differ in both words.
+  int128_t last = -(int128_t(1) << 100);
+  for (int i = 0; i < kNumPop; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      const int128_t x = last + (int128_t(xorshift64() % 4) << 64) + xorshift64() % 1000;
+      rh.push(x);
+      pq.push(x);
+    }
+    ASSERT_EQ(pq.size(), rh.size());
+    ASSERT_TRUE(pq.top() == rh.top());
+    last = pq.top();
+    rh.pop();
+    pq.pop();
+  }
+}
+
+TEST(encoder_test_long_double, order) {
+  typedef radix_heap::internal::encoder<long double> encoder_type;
+  vector<long double> xs = {-numeric_limits<long double>::infinity(),
+                            numeric_limits<long double>::lowest(), -1e300L, -1.5L, -1.0L,
+                            -numeric_limits<long double>::denorm_min(), 0.0L,
+                            numeric_limits<long double>::denorm_min(),
+                            numeric_limits<long double>::min(), 1.0L, 1.5L, 1e300L,
+                            numeric_limits<long double>::max(),
+                            numeric_limits<long double>::infinity()};
+  for (size_t i = 0; i < xs.size(); ++i) {
+    ASSERT_EQ(xs[i], encoder_type::decode(encoder_type::encode(xs[i])));
+    if (i > 0) {
+      ASSERT_TRUE(encoder_type::encode(xs[i - 1]) < encoder_type::encode(xs[i]));
+    }
+  }
+}
+#endif
+
+TEST(radix_heap_test_array, large) {
+  typedef array<uint64_t, 3> key_type;
+  const int kNumPop = 100000;
+
+  radix_heap::radix_heap<key_type> rh;
+  priority_queue<key_type, vector<key_type>, greater<key_type>> pq;
+  key_type last = {{0, 0, 0}};
+  for (int i = 0; i < kNumPop; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      key_type x = last;
+      const int w = xorshift64() % 3;
+      x[w] += xorshift64() % 100;
+      for (int k = w + 1; k < 3; ++k) x[k] = xorshift64();
+      if (x < last) x = last;
+      rh.push(x);
+      pq.push(x);
+    }
+    ASSERT_EQ(pq.size(), rh.size());
+    ASSERT_TRUE(pq.top() == rh.top());
+    last = pq.top();
+    rh.pop();
+    pq.pop();
+  }
+}
+
+TEST(packed_key_test, order) {
+  typedef radix_heap::packed_key<radix_heap::field<int32_t, 40>,
+                                 radix_heap::field<uint16_t, 16>,
+                                 radix_heap::field<int8_t, 8>> encoder_type;
+  static_assert(is_same<encoder_type::unsigned_key_type, uint64_t>::value, "64 bits");
+  typedef encoder_type::key_type key_type;
+
+  vector<key_type> keys;
+  for (int i = 0; i < 10000; ++i) {
+    keys.emplace_back((int32_t)xorshift64() >> (xorshift64() % 32), (uint16_t)(xorshift64() % 4),
+                      (int8_t)xorshift64());
+  }
+  keys.emplace_back(numeric_limits<int32_t>::lowest(), 0, numeric_limits<int8_t>::lowest());
+  keys.emplace_back(numeric_limits<int32_t>::max(), numeric_limits<uint16_t>::max(),
+                    numeric_limits<int8_t>::max());
+  sort(keys.begin(), keys.end());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_TRUE(keys[i] == encoder_type::decode(encoder_type::encode(keys[i])));
+    if (i > 0) {
+      ASSERT_EQ(keys[i - 1] < keys[i], encoder_type::encode(keys[i - 1]) < encoder_type::encode(keys[i]));
+    }
+  }
+}
+
+TEST(packed_key_test, pair_radix_heap) {
+  typedef radix_heap::packed_key<radix_heap::field<int, 20>, radix_heap::field<unsigned, 12>> encoder_type;
+  static_assert(is_same<encoder_type::unsigned_key_type, uint32_t>::value, "32 bits");
+  typedef encoder_type::key_type key_type;
+
+  radix_heap::pair_radix_heap<key_type, int, encoder_type> h;
+  h.push(make_tuple(5, 3u), 1);
+  h.push(make_tuple(-5, 7u), 2);
+  h.push(make_tuple(5, 1u), 3);
+  h.push(make_tuple(-5, 2u), 4);
+  vector<int> order;
+  while (!h.empty()) {
+    order.push_back(h.top_value());
+    h.pop();
+  }
+  ASSERT_EQ((vector<int>{4, 2, 3, 1}), order);
+}
+
+TEST(encoder_test_chrono, order) {
+  typedef chrono::steady_clock::time_point time_point;
+  typedef radix_heap::internal::encoder<time_point> encoder_type;
+  const time_point t0 = chrono::steady_clock::now();
+  vector<time_point> ts = {t0 - chrono::hours(1), t0 - chrono::nanoseconds(1), t0,
+                           t0 + chrono::microseconds(1), t0 + chrono::hours(1)};
+  for (size_t i = 0; i < ts.size(); ++i) {
+    ASSERT_TRUE(ts[i] == encoder_type::decode(encoder_type::encode(ts[i])));
+    if (i > 0) {
+      ASSERT_LT(encoder_type::encode(ts[i - 1]), encoder_type::encode(ts[i]));
+    }
+  }
+
+  radix_heap::radix_heap<chrono::milliseconds> h;
+  h.push(chrono::seconds(2));
+  h.push(chrono::milliseconds(-5));
+  ASSERT_EQ(-5, h.top().count());
+}
+
+TEST(timer_queue_test, run_due) {
+  typedef radix_heap::timer_queue<> queue_type;
+  typedef queue_type::time_point time_point;
+  const time_point t0;
+  queue_type q;
+  vector<int> order;
+
+  q.schedule_at(t0 + chrono::milliseconds(30), [&]() { order.push_back(30); });
+  q.schedule_at(t0 + chrono::milliseconds(10), [&]() {
+      order.push_back(10);
+      // Both are staged and run by the next call.
+      q.schedule_at(t0 + chrono::milliseconds(5), [&]() { order.push_back(5); });
+      q.schedule_at(t0 + chrono::milliseconds(15), [&]() { order.push_back(15); });
+    });
+  q.schedule_at(t0 + chrono::milliseconds(10), [&]() { order.push_back(11); });
+  ASSERT_TRUE(t0 + chrono::milliseconds(10) == q.next_deadline());
+
+  ASSERT_EQ(2u, q.run_due(t0 + chrono::milliseconds(20)));
+  ASSERT_EQ(3u, q.size());
+  // Earlier than the deadline peeked by the heap.
+  q.schedule_at(t0 + chrono::milliseconds(12), [&]() { order.push_back(12); });
+  ASSERT_TRUE(t0 + chrono::milliseconds(10) == q.next_deadline());
+
+  ASSERT_EQ(3u, q.run_due(t0 + chrono::milliseconds(20)));
+  ASSERT_TRUE(t0 + chrono::milliseconds(30) == q.next_deadline());
+  ASSERT_EQ(1u, q.run_due(t0 + chrono::milliseconds(100)));
+  ASSERT_TRUE(q.empty());
+
+  sort(order.begin(), order.begin() + 2);
+  ASSERT_EQ((vector<int>{10, 11, 5, 12, 15, 30}), order);
+}
+
+TEST(timer_queue_test, throwing_callback) {
+  typedef radix_heap::timer_queue<> queue_type;
+  const queue_type::time_point t0;
+  queue_type q;
+  vector<int> order;
+
+  q.schedule_at(t0 + chrono::milliseconds(10), [&]() {
+      q.schedule_at(t0 + chrono::milliseconds(15), [&]() { order.push_back(15); });
+      throw runtime_error("timer");
+    });
+  ASSERT_THROW(q.run_due(t0 + chrono::milliseconds(20)), runtime_error);
+  ASSERT_EQ(1u, q.size());
+
+  // Scheduled directly, not staged.
+  q.schedule_at(t0 + chrono::milliseconds(20), [&]() { order.push_back(20); });
+  ASSERT_EQ(2u, q.size());
+  ASSERT_EQ(2u, q.run_due(t0 + chrono::milliseconds(20)));
+  ASSERT_EQ((vector<int>{15, 20}), order);
+}
+
+TEST(encoder_test_bfloat16, all) {
+  typedef radix_heap::internal::encoder<radix_heap::bfloat16> encoder_type;
+  static_assert(is_same<encoder_type::unsigned_key_type, uint16_t>::value, "16 bits");
+  vector<pair<float, uint16_t>> xs;
+  for (uint32_t b = 0; b < 65536; ++b) {
+    const radix_heap::bfloat16 x = radix_heap::bfloat16::from_bits(b);
+    if (float(x) != float(x)) continue;  // NaN
+    ASSERT_EQ(b, encoder_type::decode(encoder_type::encode(x)).bits());
+    xs.emplace_back(float(x), encoder_type::encode(x));
+  }
+  sort(xs.begin(), xs.end());
+  for (size_t i = 1; i < xs.size(); ++i) {
+    if (xs[i - 1].first < xs[i].first) {
+      ASSERT_LT(xs[i - 1].second, xs[i].second);
+    }
+  }
+  ASSERT_EQ(1.5f, float(radix_heap::bfloat16(1.5f)));
+  ASSERT_EQ(1.0f, float(radix_heap::bfloat16(1.001f)));
+}
+
+#ifdef __FLT16_MAX__
+TEST(encoder_test_float16, all) {
+  typedef radix_heap::internal::encoder<_Float16> encoder_type;
+  vector<pair<float, uint16_t>> xs;
+  for (uint32_t b = 0; b < 65536; ++b) {
+    const uint16_t u = b;
+    _Float16 x;
+    memcpy(&x, &u, sizeof(x));
+    if (x != x) continue;  // NaN
+    const uint16_t y = encoder_type::encode(x);
+    const _Float16 z = encoder_type::decode(y);
+    ASSERT_EQ(0, memcmp(&x, &z, sizeof(x)));
+    xs.emplace_back(float(x), y);
+  }
+  sort(xs.begin(), xs.end());
+  for (size_t i = 1; i < xs.size(); ++i) {
+    if (xs[i - 1].first < xs[i].first) {
+      ASSERT_LT(xs[i - 1].second, xs[i].second);
+    }
+  }
+
+  radix_heap::radix_heap<_Float16> h;
+  h.push(_Float16(2.5f));
+  h.push(_Float16(-0.25f));
+  ASSERT_EQ(-0.25f, float(h.top()));
+}
+#endif
+
+TEST(radix_heap_test_fixed_point, large) {
+  typedef radix_heap::fixed_point<int64_t, 32> q32_32;
+  ASSERT_EQ(-1.25, double(q32_32(-1.25)));
+  ASSERT_TRUE(q32_32(0.5) + q32_32(0.25) == q32_32(0.75));
+
+  radix_heap::radix_heap<q32_32> rh;
+  priority_queue<int64_t, vector<int64_t>, greater<int64_t>> pq;
+  int64_t last = numeric_limits<int64_t>::lowest() / 2;
+  for (int i = 0; i < 100000; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      const int64_t x = last + (int64_t)(xorshift64() % (uint64_t(1) << 40));
+      rh.push(q32_32::from_raw(x));
+      pq.push(x);
+    }
+    ASSERT_EQ(pq.top(), rh.top().raw());
+    last = pq.top();
+    rh.pop();
+    pq.pop();
+  }
+}
+
+TEST(quantized_encoder_test, pair_radix_heap) {
+  const int kNumPop = 10000;
+  const int kMaxInsert = 10;
+
+  const radix_heap::quantized_encoder<double, uint32_t> e(-100.0, 0.01);
+  ASSERT_EQ(0u, e.encode(-100.0));
+  ASSERT_EQ(1u, e.encode(-99.991));
+  ASSERT_EQ(12345u, e.encode(e.decode(12345)));
+
+  radix_heap::pair_radix_heap<double, int, radix_heap::quantized_encoder<double, uint32_t>> rh(e);
+  multiset<pair<uint32_t, int>> se;
+  double last = -100.0;
+  for (int i = 0; i < kNumPop; ++i) {
+    int num_insert = 1 + xorshift64() % kMaxInsert;
+    for (int j = 0; j < num_insert; ++j) {
+      const double x = last + xorshift64() % 100000 * 1e-4;
+      const int v = xorshift64() % 100;
+      rh.push(x, v);
+      se.emplace(e.encode(x), v);
+    }
+
+    const double top_key = rh.top_key();
+    const int top_value = rh.top_value();
+    ASSERT_EQ(se.begin()->first, e.encode(top_key));
+    ASSERT_TRUE(se.count(make_pair(e.encode(top_key), top_value)));
+    rh.pop();
+    se.erase(se.find(make_pair(e.encode(top_key), top_value)));
+    last = top_key;
+  }
+}
+
+TEST(radix_heap_test_short, large) {
+  const int kNumTrials = 10;
+  const int kNumPop = 10000;
+  const int kMaxDiff = 100;
+  const int kMaxInsert = 10;
+
+  radix_heap::radix_heap<short> rh;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    rh.clear();
+    ASSERT_TRUE(rh.empty());
+    priority_queue<short, vector<short>, greater<short>> pq;
+
+    int last = numeric_limits<short>::lowest();
+    for (int i = 0; i < kNumPop; ++i) {
+      int num_insert = 1 + xorshift64() % kMaxInsert;
+      for (int j = 0; j < num_insert; ++j) {
+        short x = min<int>(last + xorshift64() % kMaxDiff, numeric_limits<short>::max());
+        rh.push(x);
+        pq.push(x);
+      }
+
+      ASSERT_EQ(pq.size(), rh.size());
+      ASSERT_EQ(pq.top(), rh.top());
+      last = pq.top();
+
+      rh.pop();
+      pq.pop();
+    }
+  }
+}
+
+TEST(radix_heap_test_descending, large) {
+  const int kNumTrials = 10;
+  const int kNumPop = 10000;
+  const int kMaxInsert = 10;
+
+  radix_heap::radix_heap<double, radix_heap::descending> rh;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    rh.clear();
+    ASSERT_TRUE(rh.empty());
+    priority_queue<double> pq;
+
+    double last = numeric_limits<double>::max();
+    rh.push(last);
+    pq.push(last);
+    for (int i = 0; i < kNumPop; ++i) {
+      int num_insert = 1 + xorshift64() % kMaxInsert;
+      for (int j = 0; j < num_insert; ++j) {
+        double x = last - xorshift64() % 1000 * 0.5;
+        rh.push(x);
+        pq.push(x);
+      }
+
+      ASSERT_EQ(rh.top(), pq.top());
+      last = pq.top();
+
+      rh.pop();
+      pq.pop();
+    }
+  }
+}
+
+TEST(pair_radix_heap_test_descending, widest_path) {
+  radix_heap::pair_radix_heap<uint32_t, int, radix_heap::descending> rh;
+  rh.push(numeric_limits<uint32_t>::max(), 0);
+  rh.push(0, 1);
+  ASSERT_EQ(numeric_limits<uint32_t>::max(), rh.top_key());
+  rh.pop();
+  rh.push(7, 2);
+  rh.push(7, 3);
+  rh.push(3, 4);
+
+  vector<int> group;
+  ASSERT_EQ(7u, rh.pop_top_group(group));
+  sort(group.begin(), group.end());
+  ASSERT_EQ(vector<int>({2, 3}), group);
+  ASSERT_EQ(3u, rh.top_key());
+  ASSERT_EQ(4, rh.top_value());
+  rh.pop();
+  ASSERT_EQ(0u, rh.top_key());
+  ASSERT_EQ(1, rh.top_value());
+  rh.pop();
+  ASSERT_TRUE(rh.empty());
+}
+
+TEST(serial_radix_heap_test, wraparound) {
+  const int kNumPop = 100000;
+  const int kMaxDiff = 1000;
+
+  // Pushes one element per pop on average, so keys wrap around hundreds of
+  // times.
+  uint64_t last = 65000;
+  radix_heap::serial_radix_heap<uint16_t> rh(last);
+  priority_queue<uint64_t, vector<uint64_t>, greater<uint64_t>> pq;
+  for (int i = 0; i < kNumPop; ++i) {
+    int num_insert = pq.empty() ? 1 : xorshift64() % 3;
+    for (int j = 0; j < num_insert; ++j) {
+      uint64_t x = last + xorshift64() % kMaxDiff;
+      rh.push(uint16_t(x));
+      pq.push(x);
+    }
+
+    ASSERT_EQ(uint16_t(pq.top()), rh.top());
+    last = pq.top();
+    rh.pop();
+    pq.pop();
+    ASSERT_EQ(pq.size(), rh.size());
+  }
+}
+
+TEST(serial_pair_radix_heap_test, wraparound) {
+  radix_heap::serial_pair_radix_heap<uint32_t, int> rh(0xffffff00u);
+  rh.push(0xfffffff0u, 1);
+  rh.push(0x00000010u, 3);
+  rh.push(0xffffffffu, 2);
+  ASSERT_EQ(0xfffffff0u, rh.top_key());
+  ASSERT_EQ(1, rh.top_value());
+  rh.pop();
+  ASSERT_EQ(0xffffffffu, rh.top_key());
+  rh.pop();
+  rh.push(0x00000005u, 4);
+  rh.push(0x00000005u, 5);
+
+  vector<int> group;
+  ASSERT_EQ(0x00000005u, rh.pop_top_group(group));
+  sort(group.begin(), group.end());
+  ASSERT_EQ(vector<int>({4, 5}), group);
+  ASSERT_EQ(0x00000010u, rh.top_key());
+  ASSERT_EQ(3, rh.top_value());
+
+  // Moves the base by more than 2^31.
+  rh.push(0x80000000u, 6);
+  rh.pop();
+  ASSERT_EQ(0x80000000u, rh.top_key());
+  rh.push(0x90000000u, 7);
+  rh.push(0xa0000000u, 8);
+  rh.pop();
+  ASSERT_EQ(0x90000000u, rh.top_key());
+  rh.pop();
+  rh.push(0x08000000u, 9);
+  ASSERT_EQ(0xa0000000u, rh.top_key());
+  rh.pop();
+  ASSERT_EQ(0x08000000u, rh.top_key());
+  ASSERT_EQ(9, rh.top_value());
+  rh.pop();
+  ASSERT_TRUE(rh.empty());
+}
+
+TEST(soft_radix_heap_test, large) {
+  const int kNumPop = 100000;
+  const int kMaxDiff = 1000;
+  const int kWindow = 100;
+  const int kMaxLateness = 200;
+
+  radix_heap::soft_radix_heap<int> rh(kWindow);
+  priority_queue<int, vector<int>, greater<int>> pq;
+  int last = 0;
+  for (int i = 0; i < kNumPop; ++i) {
+    int num_insert = pq.empty() ? 1 : xorshift64() % 3;
+    for (int j = 0; j < num_insert; ++j) {
+      const int x = last - kMaxLateness + xorshift64() % kMaxDiff;
+      const radix_heap::push_status s = rh.push(x);
+      if (x >= last) {
+        ASSERT_EQ(radix_heap::push_status::on_time, s);
+      } else if (x >= last - kWindow) {
+        ASSERT_EQ(radix_heap::push_status::late, s);
+      } else {
+        ASSERT_EQ(radix_heap::push_status::rejected, s);
+        continue;
+      }
+      pq.push(x);
+    }
+    if (pq.empty()) continue;
+
+    ASSERT_EQ(pq.top(), rh.top());
+    last = max(last, pq.top());
+    rh.pop();
+    pq.pop();
+    ASSERT_EQ(pq.size(), rh.size());
+  }
+}
+
+TEST(soft_pair_radix_heap_test, late) {
+  radix_heap::soft_pair_radix_heap<uint32_t, string> rh(10);
+  ASSERT_EQ(radix_heap::push_status::on_time, rh.push(100, "a"));
+  ASSERT_EQ(radix_heap::push_status::on_time, rh.push(120, "b"));
+  ASSERT_EQ(100u, rh.top_key());
+  rh.pop();
+  ASSERT_EQ(radix_heap::push_status::late, rh.push(95, "c"));
+  ASSERT_EQ(radix_heap::push_status::late, rh.push(90, "d"));
+  ASSERT_EQ(radix_heap::push_status::rejected, rh.push(89, "e"));
+  ASSERT_EQ(radix_heap::push_status::on_time, rh.emplace(100, 1, 'f'));
+  ASSERT_EQ(4u, rh.size());
+
+  ASSERT_EQ(90u, rh.top_key());
+  ASSERT_EQ("d", rh.top_value());
+  rh.pop();
+  ASSERT_EQ(95u, rh.top_key());
+  ASSERT_EQ("c", rh.top_value());
+  rh.pop();
+  ASSERT_EQ(100u, rh.top_key());
+  ASSERT_EQ("f", rh.top_value());
+  rh.pop();
+  ASSERT_EQ(120u, rh.top_key());
+  ASSERT_EQ("b", rh.top_value());
+  rh.pop();
+  ASSERT_TRUE(rh.empty());
+  ASSERT_EQ(radix_heap::push_status::rejected, rh.push(100, "g"));
+}
+
+TEST(soft_pair_radix_heap_test, move_only) {
+  radix_heap::soft_pair_radix_heap<int, unique_ptr<int>> rh(10);
+  unique_ptr<int> p(new int(1));
+  ASSERT_EQ(radix_heap::push_status::on_time, rh.push(100, std::move(p)));
+  ASSERT_EQ(100, rh.top_key());
+  rh.pop();
+  ASSERT_EQ(radix_heap::push_status::late, rh.push(95, unique_ptr<int>(new int(2))));
+  ASSERT_EQ(radix_heap::push_status::on_time, rh.emplace(110, new int(3)));
+  ASSERT_EQ(2, *rh.top_value());
+  rh.pop();
+  ASSERT_EQ(3, *rh.top_value());
+  rh.pop();
+  ASSERT_TRUE(rh.empty());
+}
+
+TEST(counting_radix_heap_test, trivial) {
+  radix_heap::counting_radix_heap<unsigned int> h;
+  ASSERT_TRUE(h.empty());
+
+  h.push(3);
+  h.push(3);
+  h.push(1, 4);
+  h.push(7, 0);
+  ASSERT_EQ(6u, h.size());
+  ASSERT_EQ(1u, h.top());
+  ASSERT_EQ(4u, h.top_count());
+
+  for (int i = 0; i < 4; ++i) h.pop();
+  h.push(3);
+  ASSERT_EQ(3u, h.size());
+  ASSERT_EQ(3u, h.top());
+  ASSERT_EQ(3u, h.top_count());
+
+  h.clear();
+  ASSERT_TRUE(h.empty());
+  h.push(0);
+  ASSERT_EQ(0u, h.top());
+  ASSERT_EQ(1u, h.top_count());
+}
+
+TEST(counting_radix_heap_test, interleaved) {
+  radix_heap::counting_radix_heap<int> rh;
+  for (int i = 0; i < 100; ++i) {
+    rh.push(1000 + i % 3);
+    rh.push(1000 - i % 3, 2);
+  }
+  rh.push(0);
+  rh.pop();
+  ASSERT_EQ(998, rh.top());
+  ASSERT_EQ(66u, rh.top_count());
+  for (int i = 0; i < 66; ++i) rh.pop();
+  ASSERT_EQ(999, rh.top());
+  ASSERT_EQ(66u, rh.top_count());
+  for (int i = 0; i < 66; ++i) rh.pop();
+  ASSERT_EQ(1000, rh.top());
+  ASSERT_EQ(102u, rh.top_count());
+  for (int i = 0; i < 102; ++i) rh.pop();
+  ASSERT_EQ(1001, rh.top());
+  ASSERT_EQ(33u, rh.top_count());
+}
+
+TEST(counting_radix_heap_test, large) {
+  const int kNumTrials = 10;
+  const int kNumPop = 10000;
+  const int kMaxDiff = 10;
+  const int kMaxInsert = 10;
+
+  radix_heap::counting_radix_heap<int> rh;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    rh.clear();
+    ASSERT_TRUE(rh.empty());
+    priority_queue<int, vector<int>, greater<int>> pq;
+
+    int last = static_cast<int>(xorshift64()) / 2;
+    for (int i = 0; i < kNumPop; ++i) {
+      int num_insert = 1 + xorshift64() % kMaxInsert;
+      for (int j = 0; j < num_insert; ++j) {
+        int x = last + xorshift64() % kMaxDiff;
+        rh.push(x);
+        pq.push(x);
+      }
+
+      ASSERT_EQ(pq.size(), rh.size());
+      ASSERT_EQ(pq.top(), rh.top());
+      last = pq.top();
+
+      rh.pop();
+      pq.pop();
+    }
+  }
+}
+
+TEST(compact_radix_heap_test, large) {
+  const int kNumTrials = 10;
+  const int kNumPop = 10000;
+  const int kMaxDiff = 1000;
+  const int kMaxInsert = 10;
+
+  radix_heap::compact_radix_heap<int> rh;
+  ASSERT_EQ(sizeof(void*), sizeof(rh));
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    rh.clear();
+    ASSERT_TRUE(rh.empty());
+    priority_queue<int, vector<int>, greater<int>> pq;
+
+    int last = static_cast<int>(xorshift64()) / 2;
+    for (int i = 0; i < kNumPop; ++i) {
+      int num_insert = 1 + xorshift64() % kMaxInsert;
+      for (int j = 0; j < num_insert; ++j) {
+        int x = last + xorshift64() % kMaxDiff;
+        rh.push(x);
+        pq.push(x);
+      }
+
+      ASSERT_EQ(pq.size(), rh.size());
+      ASSERT_EQ(pq.top(), rh.top());
+      last = pq.top();
+
+      rh.pop();
+      pq.pop();
+    }
+  }
+}
+
+TEST(small_radix_heap_test, move) {
+  typedef radix_heap::small_radix_heap<int, 4> heap_type;
+
+  heap_type h1;
+  h1.push(3);
+  h1.push(1);
+  heap_type h2(std::move(h1));
+  ASSERT_TRUE(h1.empty());
+  ASSERT_EQ(2u, h2.size());
+  ASSERT_EQ(1, h2.top());
+
+  h1.push(0);  // The moved-from heap is usable again.
+  ASSERT_EQ(0, h1.top());
+  h1 = std::move(h2);
+  ASSERT_TRUE(h2.empty());
+  ASSERT_EQ(2u, h1.size());
+  ASSERT_EQ(1, h1.top());
+}
+
+TEST(small_radix_heap_test, large) {
+  const int kNumTrials = 10;
+  const int kNumPop = 10000;
+  const int kMaxDiff = 1000;
+  const int kMaxInsert = 6;
+
+  radix_heap::small_radix_heap<int, 4> rh;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    rh.clear();
+    ASSERT_TRUE(rh.empty());
+    priority_queue<int, vector<int>, greater<int>> pq;
+
+    int last = static_cast<int>(xorshift64()) / 2;
+    for (int i = 0; i < kNumPop; ++i) {
+      // Alternates between growing and shrinking so that both modes are used.
+      int num_insert = (i / 100 % 2 == 0) ? xorshift64() % kMaxInsert : xorshift64() % 2;
+      for (int j = 0; j < num_insert; ++j) {
+        int x = last + xorshift64() % kMaxDiff;
+        rh.push(x);
+        pq.push(x);
+      }
+      ASSERT_EQ(pq.size(), rh.size());
+      if (pq.empty()) continue;
+
+      ASSERT_EQ(pq.top(), rh.top());
+      last = pq.top();
+
+      rh.pop();
+      pq.pop();
+    }
+  }
+}
+
 TEST(pair_radix_heap_test, trivial) {
   radix_heap::pair_radix_heap<double, string> h;
 
@@ -232,6 +905,48 @@ TEST(pair_radix_heap_test, trivial) {
   ASSERT_TRUE(h.empty());
 }
 
+TEST(pair_radix_heap_test_int_string, pop_top_group) {
+  radix_heap::pair_radix_heap<int, string> h;
+  vector<pair<int, string>> es = {{3, "hoge"}, {1, "piyo"}, {3, "huga"}, {1, "nya"}, {2, "foo"}};
+  h.push_range(es.begin(), es.end());
+  ASSERT_EQ(5, h.size());
+
+  vector<string> vs;
+  ASSERT_EQ(1, h.pop_top_group(vs));
+  sort(vs.begin(), vs.end());
+  ASSERT_EQ((vector<string>{"nya", "piyo"}), vs);
+  ASSERT_EQ(3, h.size());
+
+  ASSERT_EQ(2, h.pop_top_group(vs));
+  ASSERT_EQ(3, vs.size());
+  ASSERT_EQ("foo", vs.back());
+
+  vs.clear();
+  ASSERT_EQ(3, h.pop_top_group(vs));
+  ASSERT_EQ(2, vs.size());
+  ASSERT_TRUE(h.empty());
+}
+
+TEST(pair_radix_heap_test_int_int, huge_page_allocator) {
+  typedef radix_heap::huge_page_allocator<pair<int, int>> allocator_type;
+  radix_heap::pair_radix_heap<int, int, radix_heap::internal::encoder<int>, allocator_type> rh;
+  priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+
+  // Large enough for buckets to be placed in huge pages.
+  const int kNumPush = 1 << 20;
+  for (int i = 0; i < kNumPush; ++i) {
+    int x = xorshift64() % kNumPush;
+    rh.push(x, i);
+    pq.emplace(x, i);
+  }
+  while (!pq.empty()) {
+    ASSERT_EQ(pq.top().first, rh.top_key());
+    rh.pop();
+    pq.pop();
+  }
+  ASSERT_TRUE(rh.empty());
+}
+
 TEST(pair_radix_heap_test_double_string, emplace) {
   radix_heap::pair_radix_heap<double, string> h;
   h.emplace(10, "hoge");
@@ -241,6 +956,174 @@ TEST(pair_radix_heap_test_double_string, emplace) {
   ASSERT_EQ("aaaaaaaaaa", h.top_value());
 }
 
+namespace {
+struct label {
+  uint32_t dist;
+  uint32_t node;
+  string path;
+};
+
+struct dist_of {
+  uint32_t operator()(const label &l) const {
+    return l.dist;
+  }
+};
+}  // namespace
+
+TEST(radix_heap_by_test, large) {
+  const int kNumTrials = 10;
+  const int kNumPop = 10000;
+  const int kMaxDiff = 1000;
+  const int kMaxInsert = 10;
+
+  radix_heap::radix_heap_by<label, dist_of> rh;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    rh.clear();
+    ASSERT_TRUE(rh.empty());
+    set<pair<uint32_t, uint32_t>> se;
+
+    uint32_t last = xorshift64() % 1000000;
+    for (int i = 0; i < kNumPop; ++i) {
+      int num_insert = 1 + xorshift64() % kMaxInsert;
+      for (int j = 0; j < num_insert; ++j) {
+        const uint32_t x = last + xorshift64() % kMaxDiff;
+        const uint32_t v = i * kMaxInsert + j;
+        se.emplace(x, v);
+        if (j % 2 == 0) rh.push(label{x, v, random_string()});
+        else rh.emplace(label{x, v, ""});
+      }
+
+      const uint32_t top_key = rh.top_key();
+      const label &top = rh.top();
+      ASSERT_EQ(top_key, top.dist);
+      ASSERT_EQ(se.begin()->first, top_key);
+      ASSERT_TRUE(se.count(make_pair(top.dist, top.node)));
+      se.erase(make_pair(top.dist, top.node));
+      rh.pop();
+      last = top_key;
+    }
+    ASSERT_EQ(se.size(), rh.size());
+  }
+}
+
+TEST(compact_pair_radix_heap_test, copy_and_swap) {
+  typedef radix_heap::compact_pair_radix_heap<double, string> heap_type;
+  ASSERT_EQ(sizeof(void*), sizeof(heap_type));
+
+  heap_type h1;
+  ASSERT_TRUE(h1.empty());
+  h1.push(-100.0, "hoge");
+  h1.emplace(-0.5, 3, 'a');
+  h1.push(0.0, "huga");
+  ASSERT_EQ(-100.0, h1.top_key());
+  h1.pop();
+
+  heap_type h2 = h1;
+  ASSERT_EQ(2, h2.size());
+  ASSERT_EQ(-0.5, h2.top_key());
+  ASSERT_EQ("aaa", h2.top_value());
+  h2.pop();
+  ASSERT_EQ("huga", h2.top_value());
+  h2.pop();
+  ASSERT_TRUE(h2.empty());
+
+  heap_type h3;
+  h3.push(1.0, "piyo");
+  h1.swap(h3);
+  ASSERT_EQ(1, h1.size());
+  ASSERT_EQ(2, h3.size());
+  ASSERT_EQ("piyo", h1.top_value());
+
+  h1.clear();
+  ASSERT_TRUE(h1.empty());
+  h1 = std::move(h3);
+  ASSERT_EQ(-0.5, h1.top_key());
+  ASSERT_EQ(2, h1.size());
+}
+
+TEST(small_pair_radix_heap_test, copy_and_swap) {
+  typedef radix_heap::small_pair_radix_heap<double, string, 2> heap_type;
+
+  heap_type h1;
+  h1.push(-100.0, "hoge");
+  h1.emplace(-0.5, 3, 'a');
+  heap_type h2 = h1;
+  h1.push(0.0, "huga");  // Moves to buckets.
+  ASSERT_EQ(-100.0, h1.top_key());
+  h1.pop();
+  ASSERT_EQ("aaa", h1.top_value());
+
+  ASSERT_EQ(2, h2.size());
+  ASSERT_EQ("hoge", h2.top_value());
+  h2.pop();
+  ASSERT_EQ(-0.5, h2.top_key());
+  ASSERT_EQ("aaa", h2.top_value());
+
+  h1.swap(h2);
+  ASSERT_EQ(1, h1.size());
+  ASSERT_EQ(2, h2.size());
+  h1.pop();
+  ASSERT_TRUE(h1.empty());
+  h2.pop();
+  ASSERT_EQ("huga", h2.top_value());
+  h2.pop();
+  ASSERT_TRUE(h2.empty());
+
+  h2.push(1.0, "piyo");  // Back to the inline array.
+  h1 = std::move(h2);
+  ASSERT_EQ("piyo", h1.top_value());
+}
+
+TEST(small_pair_radix_heap_test, push_own_element) {
+  const string a(100, 'a'), b(100, 'b');
+  radix_heap::small_pair_radix_heap<int, string, 4> h;
+  h.push(1, a);
+  h.push(5, b);
+  h.push(3, "ccc");
+  h.push(10, h.top_value());  // Shifts the elements in the inline array.
+  h.push(2, h.top_value());  // Moves the elements to buckets.
+  h.push(20, h.top_value());
+
+  ASSERT_EQ(6u, h.size());
+  const int keys[] = {1, 2, 3, 5, 10, 20};
+  const string values[] = {a, a, "ccc", b, a, a};
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_EQ(keys[i], h.top_key());
+    ASSERT_EQ(values[i], h.top_value());
+    h.pop();
+  }
+}
+
+TEST(small_pair_radix_heap_test_int_string, large) {
+  const int kNumPop = 100000;
+  const int kMaxDiff = 1000;
+  const int kMaxInsert = 6;
+
+  radix_heap::small_pair_radix_heap<int, string, 4> rh;
+  set<pair<int, string>> se;
+  int last = 0;
+  for (int i = 0; i < kNumPop; ++i) {
+    int num_insert = (i / 100 % 2 == 0) ? xorshift64() % kMaxInsert : xorshift64() % 2;
+    for (int j = 0; j < num_insert; ++j) {
+      int x = last + xorshift64() % kMaxDiff;
+      string s = random_string();
+      se.emplace(x, s);
+      rh.push(x, s);
+    }
+    ASSERT_EQ(se.size(), rh.size());
+    if (se.empty()) continue;
+
+    int top_key = rh.top_key();
+    string top_value = rh.top_value();
+    ASSERT_EQ(top_key, (*se.begin()).first);
+    ASSERT_TRUE(se.count(make_pair(top_key, top_value)));
+
+    rh.pop();
+    se.erase(make_pair(top_key, top_value));
+    last = top_key;
+  }
+}
+
 TEST(pair_radix_heap_test_int_string, large) {
   const int kNumTrials = 10;
   const int kNumPop = 10000;
@@ -276,3 +1159,456 @@ TEST(pair_radix_heap_test_int_string, large) {
     }
   }
 }
+
+TEST(string_radix_heap_test, large) {
+  const int kNumTrials = 3;
+  const int kNumPop = 20000;
+  const int kMaxInsert = 10;
+
+  radix_heap::string_radix_heap<int> rh;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    rh.clear();
+    ASSERT_TRUE(rh.empty());
+    multiset<pair<string, int>> se;
+
+    string last;
+    for (int i = 0; i < kNumPop; ++i) {
+      int num_insert = 1 + xorshift64() % kMaxInsert;
+      for (int j = 0; j < num_insert; ++j) {
+        // A key not less than |last|, often sharing a long prefix with it.
+        string s = last.substr(0, xorshift64() % (last.size() + 1));
+        if (s.size() < last.size()) {
+          const unsigned char c = last[s.size()];
+          if (c == 255) continue;
+          s += char(c + 1 + xorshift64() % (255 - c));
+        }
+        const int len = xorshift64() % 24;
+        for (int k = 0; k < len; ++k) s += char(xorshift64() % 4 == 0 ? 0xf0 : 'a' + xorshift64() % 3);
+        const int v = xorshift64() % 100;
+        se.emplace(s, v);
+        if (j % 2 == 0) rh.push(s, v);
+        else rh.push(s.data(), s.size(), v);
+      }
+
+      const string top_key = rh.top_key();
+      const int top_value = rh.top_value();
+      ASSERT_EQ(se.begin()->first, top_key);
+      ASSERT_TRUE(se.count(make_pair(top_key, top_value)));
+      rh.pop();
+      se.erase(se.find(make_pair(top_key, top_value)));
+      last = top_key;
+    }
+    ASSERT_EQ(se.size(), rh.size());
+  }
+}
+
+TEST(shm_pair_radix_heap_test, large) {
+  typedef radix_heap::shm_pair_radix_heap<int, int> heap_t;
+  const uint32_t kCapacity = 1000;
+  vector<uint64_t> segment(heap_t::required_bytes(kCapacity) / sizeof(uint64_t) + 1);
+  heap_t rh = heap_t::create(segment.data(), kCapacity);
+  ASSERT_EQ(kCapacity, rh.capacity());
+  priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+
+  int last = numeric_limits<int>::lowest();
+  for (int iter = 0; iter < 100000; ++iter) {
+    if (pq.size() < kCapacity && xorshift64() % 2 == 0) {
+      const int k = last + (int)(xorshift64() % 100);
+      ASSERT_TRUE(rh.push(k, k ^ 12345));
+      pq.emplace(k, k ^ 12345);
+    } else if (!pq.empty()) {
+      int k, v;
+      ASSERT_TRUE(rh.try_pop(&k, &v));
+      ASSERT_EQ(pq.top().first, k);
+      ASSERT_EQ(k ^ 12345, v);
+      pq.pop();
+      last = k;
+    }
+    ASSERT_EQ(pq.size(), rh.size());
+  }
+
+  for (size_t i = pq.size(); i < kCapacity; ++i) ASSERT_TRUE(rh.push(last, 0));
+  ASSERT_FALSE(rh.push(last, 0));
+  rh.clear();
+  ASSERT_TRUE(rh.empty());
+}
+
+struct shm_event {
+  int producer, index;
+};
+
+TEST(shm_pair_radix_heap_test, fork) {
+  typedef radix_heap::shm_pair_radix_heap<double, shm_event> heap_t;
+  const uint32_t kCapacity = 10000;
+  const size_t bytes = heap_t::required_bytes(kCapacity);
+  void *segment = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, segment);
+  heap_t::create(segment, kCapacity);
+
+  const int kNumChildren = 4;
+  for (int c = 0; c < kNumChildren; ++c) {
+    if (fork() == 0) {
+      heap_t rh = heap_t::attach(segment);
+      for (int i = 0; i < 1000; ++i) rh.push(i * 0.5, shm_event{c, i});
+      _exit(0);
+    }
+  }
+  for (int c = 0; c < kNumChildren; ++c) wait(NULL);
+
+  heap_t rh = heap_t::attach(segment);
+  ASSERT_EQ(kNumChildren * 1000, rh.size());
+  double last = -1, k;
+  shm_event v;
+  while (rh.try_pop(&k, &v)) {
+    ASSERT_LE(last, k);
+    ASSERT_EQ(v.index * 0.5, k);
+    last = k;
+  }
+  munmap(segment, bytes);
+}
+
+#ifdef __linux__
+TEST(shm_pair_radix_heap_test, owner_died) {
+  typedef radix_heap::shm_pair_radix_heap<int, int> heap_t;
+  const uint32_t kCapacity = 10;
+  const size_t bytes = heap_t::required_bytes(kCapacity);
+  void *segment = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, segment);
+  heap_t rh = heap_t::create(segment, kCapacity);
+  rh.push(5, 0);
+  rh.push(10, 1);
+  int k, v;
+  ASSERT_TRUE(rh.try_pop(&k, &v));
+  ASSERT_EQ(5, k);
+
+  if (fork() == 0) {
+    // The mutex follows the 64-bit magic number at the head of the segment.
+    pthread_mutex_lock(reinterpret_cast<pthread_mutex_t*>(static_cast<uint64_t*>(segment) + 1));
+    _exit(0);
+  }
+  wait(NULL);
+
+  // Between the last popped key and the minimum key left.
+  ASSERT_TRUE(rh.push(7, 2));
+  ASSERT_EQ(2u, rh.size());
+  ASSERT_TRUE(rh.try_pop(&k, &v));
+  ASSERT_EQ(7, k);
+  ASSERT_EQ(2, v);
+  ASSERT_TRUE(rh.try_pop(&k, &v));
+  ASSERT_EQ(10, k);
+  ASSERT_EQ(1, v);
+  ASSERT_TRUE(rh.empty());
+  munmap(segment, bytes);
+}
+#endif
+
+TEST(concurrent_radix_multiqueue_test, trivial) {
+  radix_heap::concurrent_radix_multiqueue<int, string> q(1);
+  ASSERT_TRUE(q.empty());
+  ASSERT_EQ(numeric_limits<int>::max(), q.lower_bound());
+
+  q.push(10, "hoge");
+  q.push(-5, "piyo");
+  ASSERT_EQ(2, q.size());
+  ASSERT_EQ(-5, q.lower_bound());
+
+  int k1, k2;
+  string v1, v2;
+  ASSERT_TRUE(q.try_pop(&k1, &v1));
+  q.push(-10, "huga");  // Older than a key which may have been extracted.
+  ASSERT_TRUE(q.try_pop(&k2, &v2));
+  ASSERT_EQ(1, q.size());
+
+  set<pair<int, string>> se = {{k1, v1}, {k2, v2}};
+  int k3;
+  string v3;
+  ASSERT_TRUE(q.try_pop(&k3, &v3));
+  se.emplace(k3, v3);
+  ASSERT_FALSE(q.try_pop(&k3, &v3));
+  ASSERT_EQ((set<pair<int, string>>{{-10, "huga"}, {-5, "piyo"}, {10, "hoge"}}), se);
+}
+
+TEST(concurrent_radix_multiqueue_test, concurrent) {
+  const int kNumThreads = 4;
+  const int kNumPushPerThread = 100000;
+
+  radix_heap::concurrent_radix_multiqueue<int, int> q(kNumThreads);
+  vector<vector<int>> popped(kNumThreads);
+  vector<thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+        for (int i = 0; i < kNumPushPerThread; ++i) {
+          q.push(i, t * kNumPushPerThread + i);
+          int k, v;
+          if (i % 2 == 1 && q.try_pop(&k, &v)) popped[t].push_back(v);
+        }
+        int k, v;
+        while (q.try_pop(&k, &v)) popped[t].push_back(v);
+      });
+  }
+  for (auto &t : threads) t.join();
+
+  ASSERT_TRUE(q.empty());
+  vector<int> all;
+  for (const auto &p : popped) all.insert(all.end(), p.begin(), p.end());
+  sort(all.begin(), all.end());
+  ASSERT_EQ(kNumThreads * kNumPushPerThread, all.size());
+  for (int i = 0; i < kNumThreads * kNumPushPerThread; ++i) ASSERT_EQ(i, all[i]);
+}
+
+TEST(mpsc_radix_heap_test, late) {
+  radix_heap::mpsc_radix_heap<int, string> h(1, 4);
+  auto p = h.make_producer();
+  ASSERT_THROW(h.make_producer(), length_error);
+  ASSERT_TRUE(h.empty());
+
+  ASSERT_TRUE(p.try_push(10, "hoge"));
+  ASSERT_TRUE(p.try_push(5, "piyo"));
+  ASSERT_EQ(5, h.top_key());
+  ASSERT_EQ("piyo", h.top_value());
+  h.pop();
+
+  ASSERT_TRUE(p.try_push(3, "huga"));
+  ASSERT_TRUE(p.try_push(7, "nya"));
+  for (int i = 0; i < 2; ++i) ASSERT_TRUE(p.try_push(20, "foo"));
+  ASSERT_FALSE(p.try_push(30, "bar"));
+
+  ASSERT_EQ(1, h.drain());
+  ASSERT_EQ(1, h.late().size());
+  ASSERT_EQ(3, h.late()[0].first);
+  ASSERT_EQ(4, h.size());
+  ASSERT_EQ("nya", h.top_value());
+}
+
+TEST(mpsc_radix_heap_test, concurrent) {
+  const int kNumProducers = 4;
+  const int kNumPushPerProducer = 100000;
+
+  radix_heap::mpsc_radix_heap<int, int> h(kNumProducers, 256);
+  vector<thread> producers;
+  for (int t = 0; t < kNumProducers; ++t) {
+    producers.emplace_back([&h, t]() {
+        auto p = h.make_producer();
+        for (int i = 0; i < kNumPushPerProducer; ++i) p.push(i, t);
+      });
+  }
+
+  int num_popped = 0;
+  int last = numeric_limits<int>::lowest();
+  while (num_popped + (int)h.late().size() < kNumProducers * kNumPushPerProducer) {
+    if (h.empty()) continue;
+    ASSERT_LE(last, h.top_key());
+    last = h.top_key();
+    h.pop();
+    ++num_popped;
+  }
+  for (auto &t : producers) t.join();
+  ASSERT_TRUE(h.empty());
+  for (const auto &e : h.late()) ASSERT_LT(e.first, last);
+}
+
+TEST(mpsc_radix_heap_test, pop_after_top) {
+  radix_heap::mpsc_radix_heap<int, string> h(1, 4);
+  auto p = h.make_producer();
+  ASSERT_TRUE(p.try_push(5, "hoge"));
+  ASSERT_EQ("hoge", h.top_value());
+  // Pushed between |top_value| and |pop| with the same key.
+  ASSERT_TRUE(p.try_push(5, "piyo"));
+  h.pop();
+  ASSERT_EQ("piyo", h.top_value());
+  h.pop();
+  ASSERT_TRUE(h.empty());
+}
+
+TEST(mpsc_radix_heap_test, equal_keys) {
+  const int kNumProducers = 4;
+  const int kNumPushPerProducer = 100000;
+
+  // Many elements share keys, so producers keep appending to bucket 0
+  // between |top_value| and |pop|.
+  radix_heap::mpsc_radix_heap<int, int> h(kNumProducers, 256);
+  vector<thread> producers;
+  for (int t = 0; t < kNumProducers; ++t) {
+    producers.emplace_back([&h, t]() {
+        auto p = h.make_producer();
+        for (int i = 0; i < kNumPushPerProducer; ++i) {
+          p.push(i / 1000, t * kNumPushPerProducer + i);
+        }
+      });
+  }
+
+  vector<int> count(kNumProducers * kNumPushPerProducer);
+  int num_popped = 0;
+  while (num_popped + (int)h.late().size() < kNumProducers * kNumPushPerProducer) {
+    if (h.empty()) continue;
+    ++count[h.top_value()];
+    h.pop();
+    ++num_popped;
+  }
+  for (auto &t : producers) t.join();
+  ASSERT_TRUE(h.empty());
+  for (const auto &e : h.late()) ++count[e.second];
+  for (int c : count) ASSERT_EQ(1, c);
+}
+
+TEST(numa_sharded_radix_heap_test, concurrent) {
+  const int kNumThreads = 4;
+  const int kNumPushPerThread = 100000;
+
+  radix_heap::numa_sharded_radix_heap<int, int> h(kNumThreads);
+  ASSERT_EQ(-1, h.node_of(0));
+  vector<vector<int>> popped(kNumThreads);
+  vector<thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+        for (int i = 0; i < kNumPushPerThread; ++i) {
+          h.push(t, kNumPushPerThread - i, t * kNumPushPerThread + i);
+          int k, v;
+          if (i % 2 == 1 && h.try_pop(t, &k, &v)) popped[t].push_back(v);
+        }
+        int k, v;
+        while (h.try_pop(t, &k, &v)) popped[t].push_back(v);
+      });
+  }
+  for (auto &t : threads) t.join();
+
+  ASSERT_TRUE(h.empty());
+  for (int t = 0; t < kNumThreads; ++t) ASSERT_LE(0, h.node_of(t));
+  vector<int> all;
+  for (const auto &p : popped) all.insert(all.end(), p.begin(), p.end());
+  sort(all.begin(), all.end());
+  ASSERT_EQ(kNumThreads * kNumPushPerThread, all.size());
+  for (int i = 0; i < kNumThreads * kNumPushPerThread; ++i) ASSERT_EQ(i, all[i]);
+}
+
+TEST(concurrent_push_radix_heap_test, large) {
+  radix_heap::concurrent_push_radix_heap<int, string> h;
+  priority_queue<pair<int, string>, vector<pair<int, string>>, greater<pair<int, string>>> pq;
+  int k;
+  string v;
+  ASSERT_FALSE(h.try_pop(&k, &v));
+
+  for (int iter = 0; iter < 100000; ++iter) {
+    if (xorshift64() % 3 != 0) {
+      // Some keys are less than the last popped key.
+      const int key = (pq.empty() ? 0 : pq.top().first) + (int)(xorshift64() % 1000) - 10;
+      const string value = random_string();
+      h.push(key, value);
+      pq.emplace(key, value);
+    } else if (!pq.empty()) {
+      ASSERT_TRUE(h.try_pop(&k, &v));
+      ASSERT_EQ(pq.top().first, k);
+      pq.pop();
+    }
+    ASSERT_EQ(pq.size(), h.size());
+  }
+}
+
+TEST(concurrent_push_radix_heap_test, concurrent) {
+  const int kNumProducers = 4;
+  const int kNumPushPerProducer = 100000;
+
+  radix_heap::concurrent_push_radix_heap<int, int> h;
+  vector<thread> producers;
+  for (int t = 0; t < kNumProducers; ++t) {
+    producers.emplace_back([&h, t]() {
+        for (int i = 0; i < kNumPushPerProducer; ++i) {
+          h.push(i + (int)(radix_heap::internal::thread_random() % 100), t * kNumPushPerProducer + i);
+        }
+      });
+  }
+
+  vector<int> popped;
+  int k, v;
+  while ((int)popped.size() < kNumProducers * kNumPushPerProducer) {
+    if (h.try_pop(&k, &v)) popped.push_back(v);
+  }
+  for (auto &t : producers) t.join();
+  ASSERT_TRUE(h.empty());
+  ASSERT_FALSE(h.try_pop(&k, &v));
+  sort(popped.begin(), popped.end());
+  for (int i = 0; i < kNumProducers * kNumPushPerProducer; ++i) ASSERT_EQ(i, popped[i]);
+}
+
+TEST(thread_pool_executor_test, run) {
+  radix_heap::thread_pool_executor executor(4);
+  ASSERT_EQ(4, executor.concurrency());
+  for (int n = 0; n < 100; ++n) {
+    vector<int> a(n);
+    executor.run(n, [&](size_t i) { a[i] += i; });
+    for (int i = 0; i < n; ++i) ASSERT_EQ(i, a[i]);
+  }
+}
+
+TEST(work_stealing_executor_test, run_with_worker) {
+  radix_heap::work_stealing_executor executor(4);
+  ASSERT_EQ(4, executor.concurrency());
+  for (int n = 0; n < 300; n += 7) {
+    vector<int> a(n), worker(n);
+    executor.run_with_worker(n, 3, [&](size_t w, size_t i) {
+        // Uneven tasks so that ranges get stolen.
+        if (i % 50 == 0) this_thread::sleep_for(chrono::microseconds(100));
+        a[i] += i;
+        worker[i] = w;
+      });
+    for (int i = 0; i < n; ++i) {
+      ASSERT_EQ(i, a[i]);
+      ASSERT_LT(worker[i], 4);
+    }
+  }
+
+  vector<int> a(100);
+  executor.run(a.size(), [&](size_t i) { a[i] += i; });
+  for (int i = 0; i < 100; ++i) ASSERT_EQ(i, a[i]);
+}
+
+TEST(parallel_pair_radix_heap_test, swap) {
+  radix_heap::thread_pool_executor executor1(2), executor2(2);
+  radix_heap::parallel_pair_radix_heap<int, int> h1(executor1, 1), h2(executor2, 4);
+  for (int i = 0; i < 10; ++i) h1.push(i * 3, i);
+  h2.push(100, -1);
+  h2.push(50, -2);
+
+  h1.swap(h2);
+  ASSERT_EQ(2u, h1.size());
+  ASSERT_EQ(50, h1.top_key());
+  ASSERT_EQ(-2, h1.top_value());
+  h1.pop();
+  ASSERT_EQ(-1, h1.top_value());
+
+  ASSERT_EQ(10u, h2.size());
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(i * 3, h2.top_key());
+    ASSERT_EQ(i, h2.top_value());
+    h2.pop();
+  }
+}
+
+TEST(parallel_pair_radix_heap_test_int_string, large) {
+  const int kNumPop = 100000;
+  const int kMaxDiff = 100000;
+  const int kMaxInsert = 10;
+
+  radix_heap::thread_pool_executor executor(4);
+  radix_heap::parallel_pair_radix_heap<int, string> rh(executor, 64);
+  set<pair<int, string>> se;
+  int last = static_cast<int>(xorshift64()) / 2;
+  for (int i = 0; i < kNumPop; ++i) {
+    int num_insert = 1 + xorshift64() % kMaxInsert;
+    for (int j = 0; j < num_insert; ++j) {
+      int x = last + xorshift64() % kMaxDiff;
+      string s = random_string();
+      se.emplace(x, s);
+      rh.push(x, s);
+    }
+
+    int top_key = rh.top_key();
+    string top_value = rh.top_value();
+    ASSERT_EQ(top_key, (*se.begin()).first);
+    ASSERT_TRUE(se.count(make_pair(top_key, top_value)));
+
+    rh.pop();
+    se.erase(make_pair(top_key, top_value));
+    last = top_key;
+  }
+}
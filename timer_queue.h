@@ -0,0 +1,110 @@
+#pragma once
+#include "radix_heap.h"
+#include <chrono>
+#include <functional>
+
+namespace radix_heap {
+// A queue of callbacks run at deadlines of |Clock|, backed by
+// |pair_radix_heap|. Deadlines earlier than the last deadline run are
+// treated as that deadline, so timers are always run in non-decreasing
+// order of their deadlines.
+//
+// Timers scheduled by callbacks during |run_due| are staged and added after
+// the sweep, so they are run by the next call to |run_due| at the earliest.
+// If a callback throws, the exception propagates out of |run_due| after the
+// staged timers are added.
+template<typename Clock = std::chrono::steady_clock, typename Callback = std::function<void()>>
+class timer_queue {
+ public:
+  typedef Clock clock_type;
+  typedef typename Clock::time_point time_point;
+  typedef Callback callback_type;
+
+  timer_queue() : last_(time_point::min()), floor_(time_point::min()), running_(false) {}
+
+  void schedule_at(time_point deadline, callback_type callback) {
+    deadline = std::max(deadline, last_);
+    if (running_) staged_.emplace_back(deadline, std::move(callback));
+    else add(deadline, std::move(callback));
+  }
+
+  // Runs the callbacks of all timers whose deadlines are at or before |now|.
+  // Timers sharing a deadline are taken from the heap at once. Returns the
+  // number of callbacks run.
+  size_t run_due(time_point now) {
+    size_t num_run = 0;
+    running_ = true;
+    try {
+      while (!empty() && next_deadline() <= now) {
+        if (!early_.empty() && early_.front().first <= floor_) {
+          std::pop_heap(early_.begin(), early_.end(), later());
+          entry e = std::move(early_.back());
+          early_.pop_back();
+          last_ = e.first;
+          e.second();
+          ++num_run;
+        } else {
+          group_.clear();
+          last_ = heap_.pop_top_group(group_);
+          for (auto &callback : group_) callback();
+          num_run += group_.size();
+        }
+      }
+    } catch (...) {
+      add_staged();
+      throw;
+    }
+    add_staged();
+    return num_run;
+  }
+
+  // The earliest deadline. The queue must not be empty.
+  time_point next_deadline() {
+    if (!heap_.empty()) floor_ = heap_.top_key();
+    if (early_.empty()) return floor_;
+    return heap_.empty() ? early_.front().first : std::min(floor_, early_.front().first);
+  }
+
+  size_t size() const {
+    return heap_.size() + early_.size();
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+ private:
+  typedef std::pair<time_point, callback_type> entry;
+
+  struct later {
+    bool operator()(const entry &a, const entry &b) const {
+      return a.first > b.first;
+    }
+  };
+
+  pair_radix_heap<time_point, callback_type> heap_;
+  // Timers earlier than |floor_|, the minimum key the heap has looked at,
+  // which the heap can no longer accept.
+  std::vector<entry> early_;
+  time_point last_, floor_;
+  bool running_;
+  std::vector<callback_type> group_;
+  std::vector<entry> staged_;
+
+  void add(time_point deadline, callback_type &&callback) {
+    if (deadline < floor_) {
+      early_.emplace_back(deadline, std::move(callback));
+      std::push_heap(early_.begin(), early_.end(), later());
+    } else {
+      heap_.push(deadline, std::move(callback));
+    }
+  }
+
+  // Ends a sweep of |run_due|, adding the timers staged during it.
+  void add_staged() {
+    running_ = false;
+    for (auto &e : staged_) add(std::max(e.first, last_), std::move(e.second));
+    staged_.clear();
+  }
+};
+}  // namespace radix_heap